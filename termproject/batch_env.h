@@ -0,0 +1,299 @@
+﻿#pragma once
+// --- 여러 자동차 동시 시뮬레이션 (주행 에이전트 학습용) ---
+// 서로 독립인 N 대의 자동차를 step() 한 번에 한 틱씩 진행한다. 규칙은 stepCar (updateCar 와 같은 이동 / 충돌 / 피니시 판정)
+// 그대로이고, 같은 순서의 float 연산, 같은 sinf / cosf, 같은 트랙 표 보간을 써서 결과도 stepCar 와 비트 단위로 같다.
+// - 상태는 자동차마다 구조체가 아니라 값마다 배열(SoA): x[], z[], angle[] ... 이라 SSE2 로 4 대씩 계산한다.
+// - 진행 방향(sinf / cosf)은 자동차마다 저장해 두고 회전한 차만 다시 계산한다. (직진하는 틱은 삼각함수 없음)
+// - BATCH_ENV_BLOCK 대씩 묶어 스레드 풀에 나눠 준다.
+// 행동은 리플레이와 같은 키 마스크 (REPLAY_KEY_*), 관측은 중심선과의 거리 / 방향 오차 / 진행률.
+// 끝난 차(완주 / 충돌)는 resetDone() 으로 다시 출발시킬 때까지 멈춰 있고, 관측은 끝난 틱의 값으로 남는다.
+// 트랙 표는 읽기만 하므로 만들기 전에 prepareTrackSamplers(trackLength) 를 해 둘 것.
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "simulation.h"
+#include "replay.h"        // REPLAY_KEY_* (행동 키 마스크)
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BATCH_ENV_SSE2 1
+#include <emmintrin.h>
+#else
+#define BATCH_ENV_SSE2 0
+#endif
+
+const int BATCH_ENV_LANES = 4;      // SIMD 한 번에 계산하는 자동차 수 (배열은 이 배수로 채움)
+const int BATCH_ENV_BLOCK = 1024;   // 스레드 하나가 한 번에 맡는 자동차 수
+
+class BatchEnv {
+public:
+    BatchEnv(int mapType, int count, float trackLength = DEFAULT_TRACK_LENGTH, int simHz = DEFAULT_SIM_HZ)
+        : map(mapType), cars(count), padded((count + BATCH_ENV_LANES - 1) / BATCH_ENV_LANES * BATCH_ENV_LANES),
+          track(getTrackSampler(mapType)) {
+        assert(trackSamplerReady(mapType, trackLength));
+        dt = 1.0f / simHz;
+        moveStep = CAR_SPEED * dt;   // stepCar 와 같은 계산
+        turnStep = CAR_ROT_SPEED * dt;
+        finishZ = getFinishLineZ(trackLength);
+        finishArc = track.arcLengthAt(finishZ);
+        startX = track.centerX(0.0f);
+
+        for (std::vector<float>* v : { &x, &z, &angle, &forwardX, &forwardZ, &centerOffset, &headingError, &progress }) {
+            v->assign(padded, 0.0f);
+        }
+        ticks.assign(padded, 0);
+        startTicks.assign(padded, -1);
+        results.assign(padded, STEP_RUNNING);
+        doneFlags.assign(cars, 0);
+        reset();
+    }
+
+    int size() const { return cars; }
+    int mapType() const { return map; }
+
+    // 모두 출발점으로
+    void reset() {
+        for (int i = 0; i < padded; ++i) resetLane(i);
+        for (int i = cars; i < padded; ++i) results[i] = STEP_FINISHED; // 채운 자리는 항상 끝난 상태
+    }
+
+    // 끝난 차만 다시 출발 (에피소드 자동 재시작). 다시 출발한 수를 돌려준다.
+    int resetDone() {
+        int count = 0;
+        for (int i = 0; i < cars; ++i) {
+            if (results[i] == STEP_RUNNING) continue;
+            resetLane(i);
+            count++;
+        }
+        return count;
+    }
+
+    // 한 틱 진행. actions[i] = 자동차 i 의 키 마스크. pool 을 주면 블록 단위로 나눠 처리
+    void step(const uint8_t* actions, ThreadPool* pool = NULL) {
+        int blocks = (padded + BATCH_ENV_BLOCK - 1) / BATCH_ENV_BLOCK;
+        auto run = [&](int first, int last) {
+            stepRange(actions, first * BATCH_ENV_BLOCK, std::min(padded, last * BATCH_ENV_BLOCK));
+        };
+        if (pool && blocks > 1) pool->parallelFor(blocks, run);
+        else run(0, blocks);
+    }
+
+    // --- 관측 (자동차 수만큼, SoA) ---
+    const float* centerOffsets() const { return centerOffset.data(); }  // x - 도로 중심 (충돌 판정과 같은 값, 오른쪽 +)
+    const float* headingErrors() const { return headingError.data(); }  // 자동차 방향 - 도로 방향 (-pi ~ pi, 오른쪽으로 돌아 있으면 +)
+    const float* progresses() const { return progress.data(); }         // 출발 0, 피니시라인 1 (중심선 호 길이 기준)
+    const uint8_t* done() const { return doneFlags.data(); }            // 이번 틱까지 끝났으면 1
+    StepResult result(int i) const { return (StepResult)results[i]; }
+
+    // 자동차 하나의 상태 (stepCar 결과와 비교 / 그리기용)
+    CarState carState(int i) const {
+        CarState s;
+        s.mapType = map;
+        s.finishZ = finishZ;
+        s.x = x[i];
+        s.z = z[i];
+        s.angle = angle[i];
+        s.tick = ticks[i];
+        s.timerStarted = startTicks[i] >= 0;
+        s.startTick = s.timerStarted ? startTicks[i] : 0;
+        s.elapsedTime = elapsedMs(i);
+        s.finishReached = results[i] == STEP_FINISHED;
+        return s;
+    }
+
+    // stepCar 는 틱을 올리기 전에 시간을 갱신하므로 (틱 - 1 - 시작 틱)
+    int elapsedMs(int i) const {
+        return startTicks[i] >= 0 ? ticksToMs(ticks[i] - 1 - startTicks[i], dt) : 0;
+    }
+
+private:
+    void resetLane(int i) {
+        x[i] = startX;
+        z[i] = 0.0f;
+        angle[i] = 0.0f;
+        forwardX[i] = sinf(0.0f);
+        forwardZ[i] = -cosf(0.0f);
+        ticks[i] = 0;
+        startTicks[i] = -1;
+        results[i] = STEP_RUNNING;
+        if (i < cars) doneFlags[i] = 0;
+        observeLane(i);
+    }
+
+    // 관측 한 대 (표 밖이거나 SIMD 가 없을 때)
+    void observeLane(int i) {
+        centerOffset[i] = x[i] - track.centerX(z[i]);
+        headingError[i] = wrapAngle(angle[i] + track.angle(z[i]) - 3.14159265f);
+        progress[i] = finishArc > 0.0f ? track.arcLengthAt(z[i]) / finishArc : 0.0f;
+    }
+
+    // 트랙 표의 getRoadAngle 은 -Z 진행 방향이 pi 라서 자동차 각도로는 (pi - 도로 각도)
+    static float wrapAngle(float a) {
+        return a - 6.28318531f * rintf(a / 6.28318531f);
+    }
+
+#if BATCH_ENV_SSE2
+    void stepRange(const uint8_t* actions, int first, int last) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 move = _mm_set1_ps(moveStep);
+        const __m128 turn = _mm_set1_ps(turnStep);
+        const __m128 limit = _mm_set1_ps((ROAD_WIDTH / 2.0f) - CAR_COLLISION_RADIUS);
+        const __m128 finishLine = _mm_set1_ps(finishZ);
+        const __m128i running = _mm_set1_epi32(STEP_RUNNING);
+        const __m128i finished = _mm_set1_epi32(STEP_FINISHED);
+        const __m128i crashed = _mm_set1_epi32(STEP_CRASHED);
+
+        for (int i = first; i < last; i += BATCH_ENV_LANES) {
+            __m128i result = _mm_loadu_si128((const __m128i*)&results[i]);
+            __m128i active = _mm_cmpeq_epi32(result, running);
+            if (_mm_movemask_ps(_mm_castsi128_ps(active)) == 0) continue; // 4 대 모두 끝남
+
+            // 끝난 차와 채운 자리는 키 0 (아래 계산이 모두 "변화 없음" 이 됨)
+            int k[BATCH_ENV_LANES];
+            for (int l = 0; l < BATCH_ENV_LANES; ++l) k[l] = (i + l < cars) ? actions[i + l] : 0;
+            __m128i keys = _mm_and_si128(_mm_setr_epi32(k[0], k[1], k[2], k[3]), active);
+            __m128 up = keyMask(keys, REPLAY_KEY_UP);
+            __m128 down = keyMask(keys, REPLAY_KEY_DOWN);
+            __m128 left = keyMask(keys, REPLAY_KEY_LEFT);
+            __m128 right = keyMask(keys, REPLAY_KEY_RIGHT);
+
+            // 방향키가 처음 눌린 틱에 타이머 시작
+            __m128i tick = _mm_loadu_si128((const __m128i*)&ticks[i]);
+            __m128i startTick = _mm_loadu_si128((const __m128i*)&startTicks[i]);
+            __m128i begin = _mm_and_si128(_mm_cmpgt_epi32(keys, _mm_setzero_si128()), _mm_cmplt_epi32(startTick, _mm_setzero_si128()));
+            startTick = _mm_or_si128(_mm_and_si128(begin, tick), _mm_andnot_si128(begin, startTick));
+            _mm_storeu_si128((__m128i*)&startTicks[i], startTick);
+            _mm_storeu_si128((__m128i*)&ticks[i], _mm_sub_epi32(tick, active)); // active = -1 -> +1
+
+            // 이동 (stepCar 와 같은 순서: 전진, 후진, 왼쪽, 오른쪽)
+            __m128 px = _mm_loadu_ps(&x[i]);
+            __m128 pz = _mm_loadu_ps(&z[i]);
+            __m128 stepX = _mm_mul_ps(move, _mm_loadu_ps(&forwardX[i]));
+            __m128 stepZ = _mm_mul_ps(move, _mm_loadu_ps(&forwardZ[i]));
+            px = _mm_add_ps(px, _mm_and_ps(up, stepX));
+            pz = _mm_add_ps(pz, _mm_and_ps(up, stepZ));
+            px = _mm_sub_ps(px, _mm_and_ps(down, stepX));
+            pz = _mm_sub_ps(pz, _mm_and_ps(down, stepZ));
+            __m128 a = _mm_loadu_ps(&angle[i]);
+            a = _mm_sub_ps(a, _mm_and_ps(left, turn));
+            a = _mm_add_ps(a, _mm_and_ps(right, turn));
+            _mm_storeu_ps(&x[i], px);
+            _mm_storeu_ps(&z[i], pz);
+            _mm_storeu_ps(&angle[i], a);
+
+            // 회전한 차만 진행 방향 다시 계산
+            int turned = _mm_movemask_ps(_mm_or_ps(left, right));
+            for (int l = 0; turned; ++l, turned >>= 1) {
+                if (!(turned & 1)) continue;
+                forwardX[i + l] = sinf(angle[i + l]);
+                forwardZ[i + l] = -cosf(angle[i + l]);
+            }
+
+            // 피니시라인, 충돌 (충돌이 우선)
+            __m128 center, roadAngle, arc;
+            lookup(pz, center, roadAngle, arc);
+            __m128 offset = _mm_sub_ps(px, center);
+            __m128i hitFinish = _mm_castps_si128(_mm_cmple_ps(pz, finishLine));
+            __m128i hitSide = _mm_castps_si128(_mm_cmpgt_ps(_mm_and_ps(offset, absMask), limit));
+            __m128i next = _mm_or_si128(_mm_and_si128(hitFinish, finished), _mm_andnot_si128(hitFinish, running));
+            next = _mm_or_si128(_mm_and_si128(hitSide, crashed), _mm_andnot_si128(hitSide, next));
+            result = _mm_or_si128(_mm_and_si128(active, next), _mm_andnot_si128(active, result));
+            _mm_storeu_si128((__m128i*)&results[i], result);
+
+            // 관측
+            __m128 heading = _mm_sub_ps(_mm_add_ps(a, roadAngle), _mm_set1_ps(3.14159265f));
+            __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_div_ps(heading, _mm_set1_ps(6.28318531f))));
+            heading = _mm_sub_ps(heading, _mm_mul_ps(turns, _mm_set1_ps(6.28318531f)));
+            __m128 prog = finishArc > 0.0f ? _mm_div_ps(arc, _mm_set1_ps(finishArc)) : zero;
+            _mm_storeu_ps(&centerOffset[i], offset);
+            _mm_storeu_ps(&headingError[i], heading);
+            _mm_storeu_ps(&progress[i], prog);
+
+            int32_t r[BATCH_ENV_LANES];
+            _mm_storeu_si128((__m128i*)r, result);
+            for (int l = 0; l < BATCH_ENV_LANES && i + l < cars; ++l) doneFlags[i + l] = r[l] != STEP_RUNNING;
+        }
+    }
+
+    static __m128 keyMask(__m128i keys, int bit) {
+        __m128i b = _mm_set1_epi32(bit);
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(keys, b), b));
+    }
+
+    // 4 대의 z 에서 중심 X / 도로 각도 / 호 길이를 표에서 보간 (TrackSampler 와 같은 식). 표 밖인 차는 한 대씩 계산
+    void lookup(__m128 pz, __m128& center, __m128& roadAngle, __m128& arc) const {
+        __m128 f = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(track.tableBeginZ()), pz), _mm_set1_ps(TRACK_SAMPLE_SPACING));
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(f, _mm_setzero_ps()), _mm_cmplt_ps(f, _mm_set1_ps((float)(track.tableSize() - 1))));
+        f = _mm_and_ps(f, inside); // 표 밖이면 0 번 구간 (아래에서 덮어씀)
+        __m128i index = _mm_cvttps_epi32(f);
+        __m128 t = _mm_sub_ps(f, _mm_cvtepi32_ps(index));
+
+        int32_t n[BATCH_ENV_LANES];
+        _mm_storeu_si128((__m128i*)n, index);
+        const float* c = track.centerTable();
+        const float* g = track.angleTable();
+        const float* s = track.arcTable();
+        center = lerp4(c, n, t);
+        roadAngle = lerp4(g, n, t);
+        arc = _mm_sub_ps(lerp4(s, n, t), _mm_set1_ps(track.arcTableOrigin()));
+
+        int outside = ~_mm_movemask_ps(inside) & 0xF;
+        if (!outside) return;
+        float zs[BATCH_ENV_LANES], cs[BATCH_ENV_LANES], gs[BATCH_ENV_LANES], ss[BATCH_ENV_LANES];
+        _mm_storeu_ps(zs, pz);
+        _mm_storeu_ps(cs, center);
+        _mm_storeu_ps(gs, roadAngle);
+        _mm_storeu_ps(ss, arc);
+        for (int l = 0; l < BATCH_ENV_LANES; ++l) {
+            if (!(outside & (1 << l))) continue;
+            cs[l] = track.centerX(zs[l]);
+            gs[l] = track.angle(zs[l]);
+            ss[l] = track.arcLengthAt(zs[l]);
+        }
+        center = _mm_loadu_ps(cs);
+        roadAngle = _mm_loadu_ps(gs);
+        arc = _mm_loadu_ps(ss);
+    }
+
+    static __m128 lerp4(const float* table, const int32_t* n, __m128 t) {
+        __m128 a = _mm_setr_ps(table[n[0]], table[n[1]], table[n[2]], table[n[3]]);
+        __m128 b = _mm_setr_ps(table[n[0] + 1], table[n[1] + 1], table[n[2] + 1], table[n[3] + 1]);
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+#else
+    // SIMD 가 없으면 한 대씩 stepCar
+    void stepRange(const uint8_t* actions, int first, int last) {
+        for (int i = first; i < std::min(last, cars); ++i) {
+            if (results[i] != STEP_RUNNING) continue;
+            CarState s = carState(i);
+            s.finishReached = false;
+            results[i] = stepCar(s, unpackInput(actions[i]), dt);
+            x[i] = s.x;
+            z[i] = s.z;
+            angle[i] = s.angle;
+            ticks[i] = (int32_t)s.tick;
+            startTicks[i] = s.timerStarted ? (int32_t)s.startTick : -1;
+            doneFlags[i] = results[i] != STEP_RUNNING;
+            observeLane(i);
+        }
+    }
+#endif
+
+    int map;
+    int cars;
+    int padded;
+    const TrackSampler& track;
+    float dt, moveStep, turnStep;
+    float finishZ, finishArc, startX;
+
+    // 자동차별 상태 (SoA, padded 개)
+    std::vector<float> x, z, angle;
+    std::vector<float> forwardX, forwardZ;   // sinf(angle), -cosf(angle)
+    std::vector<int32_t> ticks, startTicks;  // 시작 전이면 startTick = -1
+    std::vector<int32_t> results;            // StepResult
+    // 관측
+    std::vector<float> centerOffset, headingError, progress;
+    std::vector<uint8_t> doneFlags;
+};
@@ -4,26 +4,56 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec3 Color;
 in vec2 TexCoord;
+in float ViewDepth;
+in vec4 Tint;
 
 out vec4 out_Color;
 
 uniform sampler2D outTexture;
 uniform int useTexture; 
 uniform int isLightSource; // 1̸     ( ü ׻ )
-uniform vec3 viewPos;      // ī޶ ġ (ݻ籤 )
+
+// Ӹ   ø    (vertex.glsl  ϰ )
+layout (std140) uniform SceneBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;        // xyz: ī޶ ġ (ݻ籤 )
+    vec4 clusterParams;  // x,y: Ŭ Ÿ ũ(px), z,w:  slice  scale, bias
+    ivec4 clusterDims;   // x,y,z: Ŭ 
+};
+
+// Ŭ   (ؽó )
+uniform samplerBuffer lightData;     // ε 3ؼ: (ġ, ݰ), (), ( )
+uniform usamplerBuffer clusterTable; // Ŭ͸ ( ε  ġ, )
+uniform usamplerBuffer lightIndices; // Ŭͺ  ε 
 
 // ε (Point Light) ü
 struct PointLight {
     vec3 position;
+    float radius;     //  Ÿ ۿ ⿩ 0 (Ŭ  )
     vec3 color;
     float constant;
     float linear;
     float quadratic;
 };
 
-//   ֺ 4 ε 
-#define NR_POINT_LIGHTS 4
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+PointLight FetchLight(int index)
+{
+    vec4 t0 = texelFetch(lightData, index * 3 + 0);
+    vec4 t1 = texelFetch(lightData, index * 3 + 1);
+    vec4 t2 = texelFetch(lightData, index * 3 + 2);
+    return PointLight(t0.xyz, t0.w, t1.rgb, t2.x, t2.y, t2.z);
+}
+
+//  ׸Ʈ  Ŭ ȣ
+int ClusterIndex()
+{
+    ivec2 tile = ivec2(gl_FragCoord.xy / clusterParams.xy);
+    int slice = int(floor(log(max(ViewDepth, 1e-4)) * clusterParams.z - clusterParams.w));
+    tile = clamp(tile, ivec2(0), clusterDims.xy - 1);
+    slice = clamp(slice, 0, clusterDims.z - 1);
+    return tile.x + clusterDims.x * (tile.y + clusterDims.y * slice);
+}
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 objectColor);
 
@@ -36,26 +66,30 @@ void main()
     } else {
         objectColor = Color;
     }
+    objectColor *= Tint.rgb;
 
     // (Light Source) ü    ׻  ǥ
     if (isLightSource == 1) {
-        out_Color = vec4(objectColor, 1.0);
+        out_Color = vec4(objectColor, Tint.a);
         return;
     }
 
     // ---    ---
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     
     // 1.  ȯ汤 (Ambient) - ʹ  ʰ
     vec3 ambient = 0.1 * vec3(1.0, 1.0, 1.0) * objectColor;
     
-    // 2. ε  (Diffuse + Specular) ջ
+    // 2.  ŬͿ  ε  (Diffuse + Specular) ջ
     vec3 result = ambient;
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, objectColor);
+    uvec2 range = texelFetch(clusterTable, ClusterIndex()).xy;
+    for(uint i = 0u; i < range.y; i++) {
+        int lightIndex = int(texelFetch(lightIndices, int(range.x + i)).r);
+        result += CalcPointLight(FetchLight(lightIndex), norm, FragPos, viewDir, objectColor);
+    }
 
-    out_Color = vec4(result, 1.0);
+    out_Color = vec4(result, Tint.a);
 }
 
 //    Լ
@@ -73,6 +107,10 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
     // Ÿ  (־ ο)
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+
+    // ݰ  0  ε巴 ٿ Ŭ 迡  Ƣ ʰ 
+    float falloff = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+    attenuation *= falloff * falloff;
     
     //  ջ
     vec3 diffuse = light.color * diff * objectColor;
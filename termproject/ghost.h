@@ -0,0 +1,118 @@
+﻿#pragma once
+// --- 고스트 (저장된 리플레이를 반투명 자동차로 같이 달리게 함) ---
+// 리플레이 파일을 통째로 읽지 않고 작은 read-ahead 버퍼로 조금씩 읽어 run 을 풀고,
+// 플레이어와 같은 틱에 stepCar 를 한 번씩 돌려 위치를 만든다. (이전 / 현재 상태를 둬서 그릴 때 보간)
+// 고스트 하나에 드는 것: 파일 핸들 + GHOST_READ_AHEAD 바이트 + CarState 2 개, 틱마다 stepCar 한 번.
+// 스트리밍이라 CRC 는 보지 않는다. (화면에만 쓰이므로 깨진 파일이면 엉뚱하게 달리다 멈출 뿐)
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "replay.h"
+
+const size_t GHOST_READ_AHEAD = 256;   // 고스트마다 읽어 두는 바이트 (run 이 보통 1~3 바이트라 수백 틱 분량)
+
+class GhostStream {
+public:
+    GhostStream() {}
+    ~GhostStream() { close(); }
+    GhostStream(const GhostStream&) = delete;
+    GhostStream& operator=(const GhostStream&) = delete;
+
+    // 지금 레이스와 같은 조건(맵, 틱 주기, 도로 길이, 규칙)으로 녹화된 리플레이만 연다
+    bool open(const std::string& path, int mapType, int simHz, float trackLength, std::string* error = NULL) {
+        close();
+        file = fopen(path.c_str(), "rb");
+        if (!file) return fail(error, "cannot open");
+        setvbuf(file, NULL, _IONBF, 0); // stdio 버퍼 없이 read-ahead 버퍼 하나만 사용
+
+        ReplayHeader h;
+        const char* bad = (fread(&h, sizeof(h), 1, file) == 1) ? checkReplayHeader(h) : "truncated";
+        if (!bad && h.buildHash != simulationBuildHash()) bad = "recorded with different simulation rules";
+        if (!bad && (h.mapType != mapType || h.simHz != simHz || h.trackLength != trackLength)) bad = "different race settings";
+        if (bad) {
+            close();
+            return fail(error, bad);
+        }
+
+        fileLeft = h.dataBytes;
+        bufPos = bufLen = 0;
+        runLeft = 0;
+        keys = 0;
+        recordedMs = h.elapsedMs;
+        resetCar(curr, mapType, trackLength);
+        prev = curr;
+        dt = 1.0f / simHz;
+        running = true;
+        return true;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = NULL;
+        running = false;
+    }
+
+    // 플레이어와 같은 틱에 한 번. 녹화가 끝났거나 완주 / 충돌하면 멈추고 파일을 닫는다.
+    void step() {
+        if (!running) return;
+        CarInput in;
+        prev = curr;
+        if (!nextInput(in) || stepCar(curr, in, dt) != STEP_RUNNING) {
+            prev = curr;
+            close();
+        }
+    }
+
+    bool active() const { return running; }
+    int recordedTime() const { return recordedMs; }
+
+    // 보간한 그릴 위치
+    CarState drawState(float alpha) const { return lerpCar(prev, curr, alpha); }
+
+private:
+    bool nextInput(CarInput& out) {
+        while (runLeft == 0) {
+            if (bufLen - bufPos < 10 && fileLeft > 0) refill(); // varint 최대 10 바이트가 버퍼에 다 있도록
+            if (bufPos >= bufLen) return false;
+            uint64_t run = 0;
+            size_t used = readVarint(buffer + bufPos, bufLen - bufPos, run);
+            if (used == 0) return false;
+            bufPos += used;
+            keys = (uint8_t)(run & 0x0F);
+            runLeft = run >> 4;
+        }
+        runLeft--;
+        out = unpackInput(keys);
+        return true;
+    }
+
+    // 남은 바이트를 앞으로 당기고 뒤를 파일에서 채움
+    void refill() {
+        size_t kept = bufLen - bufPos;
+        memmove(buffer, buffer + bufPos, kept);
+        size_t want = GHOST_READ_AHEAD - kept;
+        if (want > fileLeft) want = (size_t)fileLeft;
+        size_t got = fread(buffer + kept, 1, want, file);
+        fileLeft = (got == want) ? fileLeft - got : 0; // 잘린 파일이면 여기까지만
+        bufPos = 0;
+        bufLen = kept + got;
+    }
+
+    static bool fail(std::string* error, const char* message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    FILE* file = NULL;
+    uint8_t buffer[GHOST_READ_AHEAD];
+    size_t bufPos = 0;
+    size_t bufLen = 0;
+    uint64_t fileLeft = 0;   // 아직 읽지 않은 run 목록 바이트
+    uint64_t runLeft = 0;
+    uint8_t keys = 0;
+
+    CarState prev, curr;
+    float dt = 1.0f / DEFAULT_SIM_HZ;
+    int recordedMs = 0;
+    bool running = false;
+};
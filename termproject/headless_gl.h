@@ -0,0 +1,46 @@
+﻿#pragma once
+// --- 창 없는 GL 컨텍스트 (리눅스 벤치마크용) ---
+// EGL 의 surfaceless 플랫폼(Mesa)으로 창도 X 서버도 없이 GL 컨텍스트를 만든다.
+// 기본 프레임버퍼가 없으므로 FBO 에만 그릴 수 있다. (벤치마크 모드가 그렇게 함)
+// GPU 가 없는 기기에서는 Mesa 소프트웨어 래스터라이저(llvmpipe)가 쓰인다.
+// 윈도우에서는 지원하지 않음 (GLUT 의 숨긴 창을 씀)
+#include <string>
+
+#ifdef _WIN32
+#define HEADLESS_GL_SUPPORTED 0
+#else
+#define HEADLESS_GL_SUPPORTED 1
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+inline bool headlessGLFail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+// 성공하면 만든 컨텍스트가 호출한 스레드에 바인딩된 채로 true (GLUT 기본값처럼 호환 프로파일, 버전은 드라이버 최대)
+inline bool createHeadlessGLContext(std::string* error = NULL) {
+#if HEADLESS_GL_SUPPORTED
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay) return headlessGLFail(error, "EGL_EXT_platform_base not available");
+
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        return headlessGLFail(error, "cannot open the EGL surfaceless display (Mesa required)");
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) return headlessGLFail(error, "EGL has no desktop OpenGL");
+
+    // 설정(config) 없이 만든 컨텍스트 + 서피스 없이 바인딩 (EGL_KHR_no_config_context, EGL_KHR_surfaceless_context)
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT) return headlessGLFail(error, "cannot create an EGL context");
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        eglDestroyContext(display, context);
+        return headlessGLFail(error, "cannot make the EGL context current");
+    }
+    return true;
+#else
+    return headlessGLFail(error, "headless GL context is not supported on this platform");
+#endif
+}
@@ -0,0 +1,601 @@
+﻿#pragma once
+// --- 리더보드 ---
+// 맵별 순위 색인. "상위 K 개", "이 기록의 순위", "이름별 최고 기록" 을 O(log n) 에 답한다.
+// - 오래된 기록: rankings.board (맵별 시간순 배열 + 이름순 최고 기록 배열) 를 메모리 매핑해서 그대로 이진 탐색 (파싱 없음)
+// - 최근 기록 (board 이후 저널에 쌓인 것): 부분 트리 크기를 가진 트립(treap) + 이름별 최고 기록 std::map
+// 저널을 압축할 때 board 도 전체 기록으로 다시 만든다. (임시 파일 + 이름 바꾸기)
+//
+// 기록 추가는 메모리 색인만 바로 갱신하고, 디스크 쓰기는 락 없는 큐를 거쳐 백그라운드 스레드가 한다.
+// (UI 스레드는 디스크를 기다리지 않음) 종료할 때 close() 가 큐에 남은 기록을 모두 쓰고 스레드를 끝낸다.
+#include "ranking_journal.h"
+#include "spsc_queue.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+const int LEADERBOARD_MAPS = 2;
+const int BOARD_NAME_BYTES = 24;            // 이름 최대 23 바이트 + NUL
+const uint32_t BOARD_FORMAT_VERSION = 2;   // 2: BoardBest 에 seq 추가 (고스트 리플레이 찾기)
+const size_t RANKING_QUEUE_CAPACITY = 64;   // 쓰기 대기 큐 크기 (가득 차면 UI 스레드에 잠시 보관)
+const int RANKING_WRITER_POLL_MS = 100;     // 쓰기 스레드가 깨어나는 최대 간격
+
+// --- rankings.board 파일 형식 (리틀 엔디언, 모두 8 바이트 정렬) ---
+struct BoardEntry {          // 시간, seq 오름차순
+    float time;
+    uint32_t reserved;
+    uint64_t seq;
+    char name[BOARD_NAME_BYTES];
+};
+
+struct BoardBest {           // 이름 (strncmp) 오름차순
+    char name[BOARD_NAME_BYTES];
+    float time;
+    uint32_t reserved;
+    uint64_t seq;            // 최고 기록의 seq
+};
+
+struct BoardMapHeader {
+    uint64_t entryOffset;
+    uint64_t entryCount;
+    uint64_t bestOffset;
+    uint64_t bestCount;
+};
+
+struct BoardHeader {
+    char magic[4];           // "RKBD"
+    uint32_t version;
+    uint64_t lastSeq;        // 이 seq 까지의 기록이 들어 있음
+    BoardMapHeader maps[LEADERBOARD_MAPS];
+};
+
+static_assert(sizeof(BoardEntry) == 40, "BoardEntry layout");
+static_assert(sizeof(BoardBest) == 40, "BoardBest layout");
+static_assert(sizeof(BoardHeader) == 80, "BoardHeader layout");
+
+// 읽기 전용 메모리 매핑 파일
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        // FILE_SHARE_DELETE: 매핑한 채로 이름을 바꿀 수 있게 (새 board 를 먼저 매핑한 뒤 교체)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) { close(); return false; }
+        bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!bytes) { close(); return false; }
+        length = (size_t)fileSize.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        bytes = (const unsigned char*)p;
+        length = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) munmap((void*)bytes, length);
+#endif
+        bytes = NULL;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+    const unsigned char* bytes = NULL;
+    size_t length = 0;
+};
+
+// 순서 통계 트리: (시간, seq) 키 트립. 각 노드가 부분 트리 크기를 가져 순위 질의가 O(log n).
+class RankTree {
+public:
+    void clear() {
+        nodes.clear();
+        root = -1;
+    }
+
+    size_t size() const { return root < 0 ? 0 : nodes[root].size; }
+
+    void insert(const RankingEntry& entry, uint64_t seq) {
+        Node n;
+        n.entry = entry;
+        n.seq = seq;
+        n.priority = nextPriority();
+        nodes.push_back(n);
+        int created = (int)nodes.size() - 1;
+
+        int less, greater;
+        split(root, entry.time, seq, less, greater);
+        root = merge(merge(less, created), greater);
+    }
+
+    // time 보다 빠른 기록 수
+    size_t countLess(float time) const {
+        size_t count = 0;
+        int n = root;
+        while (n >= 0) {
+            if (nodes[n].entry.time < time) {
+                count += sizeOf(nodes[n].left) + 1;
+                n = nodes[n].right;
+            }
+            else {
+                n = nodes[n].left;
+            }
+        }
+        return count;
+    }
+
+    // 가장 빠른 k 개를 순서대로 fn(entry, seq) 에 넘긴다
+    void smallest(size_t k, const std::function<void(const RankingEntry&, uint64_t)>& fn) const {
+        std::vector<int> stack;
+        int n = root;
+        while (k > 0 && (n >= 0 || !stack.empty())) {
+            while (n >= 0) {
+                stack.push_back(n);
+                n = nodes[n].left;
+            }
+            n = stack.back();
+            stack.pop_back();
+            fn(nodes[n].entry, nodes[n].seq);
+            k--;
+            n = nodes[n].right;
+        }
+    }
+
+private:
+    struct Node {
+        RankingEntry entry;
+        uint64_t seq;
+        uint32_t priority;
+        int left = -1;
+        int right = -1;
+        size_t size = 1;
+    };
+
+    size_t sizeOf(int n) const { return n < 0 ? 0 : nodes[n].size; }
+    void update(int n) { nodes[n].size = sizeOf(nodes[n].left) + sizeOf(nodes[n].right) + 1; }
+
+    static bool keyLess(float timeA, uint64_t seqA, float timeB, uint64_t seqB) {
+        return timeA < timeB || (timeA == timeB && seqA < seqB);
+    }
+
+    // n 을 (time, seq) 보다 작은 쪽 / 크거나 같은 쪽으로 나눔
+    void split(int n, float time, uint64_t seq, int& less, int& greater) {
+        if (n < 0) { less = greater = -1; return; }
+        if (keyLess(nodes[n].entry.time, nodes[n].seq, time, seq)) {
+            int l, g;
+            split(nodes[n].right, time, seq, l, g);
+            nodes[n].right = l;
+            update(n);
+            less = n;
+            greater = g;
+        }
+        else {
+            int l, g;
+            split(nodes[n].left, time, seq, l, g);
+            nodes[n].left = g;
+            update(n);
+            less = l;
+            greater = n;
+        }
+    }
+
+    // a 의 모든 키 < b 의 모든 키
+    int merge(int a, int b) {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        if (nodes[a].priority > nodes[b].priority) {
+            nodes[a].right = merge(nodes[a].right, b);
+            update(a);
+            return a;
+        }
+        nodes[b].left = merge(a, nodes[b].left);
+        update(b);
+        return b;
+    }
+
+    uint32_t nextPriority() {
+        // xorshift32
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState;
+    }
+
+    std::vector<Node> nodes;
+    int root = -1;
+    uint32_t randomState = 2463534242u;
+};
+
+class Leaderboard {
+public:
+    explicit Leaderboard(const std::string& basePath = "rankings")
+        : journal(basePath), boardPath(basePath + ".board"), board(new MappedFile()) {}
+
+    ~Leaderboard() { close(); }
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // board 를 매핑하고 그 뒤에 저널에 쌓인 기록만 읽은 다음 쓰기 스레드를 시작한다 (시작 시 한 번)
+    void open() {
+        close();
+        recentRecords.clear();
+        rebuildRecent();
+        bool hasBoard = installBoard(boardPath, false);
+        uint64_t boardSeq = hasBoard ? boardHeader()->lastSeq : 0;
+        journal.load(boardSeq, [this](const RankingRecord& r) { addRecent(r); });
+
+        // board 가 없거나(첫 실행, 예전 형식에서 넘어옴) 많이 뒤처졌으면 지금 만든다
+        if ((!hasBoard && !recentRecords.empty()) || recentRecords.size() >= (size_t)RANKING_COMPACT_THRESHOLD) {
+            journal.compact();
+            rebuildBoard();
+        }
+        nextSeq = journal.lastSeq() + 1;
+
+        stopping = false;
+        writer = std::thread([this]() { writerLoop(); });
+    }
+
+    // 큐에 남은 기록을 모두 디스크에 쓰고 쓰기 스레드를 끝낸다 (종료 시)
+    void close() {
+        if (!writer.joinable()) return;
+        while (!pending.empty()) {
+            if (queue.tryPush(pending.front())) pending.erase(pending.begin());
+            else std::this_thread::yield();
+        }
+        stopping = true;
+        wake.notify_one();
+        writer.join();
+    }
+
+    // 완주 기록 추가. 메모리 색인은 바로 갱신하고, 디스크 쓰기는 쓰기 스레드에 맡긴다. (UI 스레드에서 호출)
+    // 돌려주는 seq 는 이 기록의 번호 (리플레이 파일 이름에 사용)
+    uint64_t add(int mapType, float time, const std::string& name) {
+        RankingRecord r;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            r = makeRankingRecord(nextSeq++, mapType, time, name);
+            addRecent(r);
+        }
+        // 큐가 가득 차 있으면 (디스크가 아주 느림) 다음 add 나 close 때 다시 넣는다
+        pending.push_back(r);
+        while (!pending.empty() && queue.tryPush(pending.front())) pending.erase(pending.begin());
+        wake.notify_one();
+        return r.seq;
+    }
+
+    // 맵의 전체 기록 수
+    size_t count(int mapType) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        int m = slot(mapType);
+        if (m < 0) return 0;
+        return boardMap(m).entryCount + recent[m].tree.size();
+    }
+
+    // 가장 빠른 k 개 (board 와 최근 기록을 병합, O(log n + k))
+    std::vector<RankingEntry> top(int mapType, int k) const {
+        std::vector<RankingEntry> result;
+        for (const RankingRecord& r : topRecords(mapType, k)) result.push_back(r.entry);
+        return result;
+    }
+
+    // top() 과 같은 순서로 seq 까지 (리플레이 파일 찾기용. timestamp 는 채우지 않음)
+    std::vector<RankingRecord> topRecords(int mapType, int k) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<RankingRecord> result;
+        int m = slot(mapType);
+        if (m < 0 || k <= 0) return result;
+
+        std::vector<RankingRecord> newer;
+        recent[m].tree.smallest((size_t)k, [&](const RankingEntry& e, uint64_t seq) {
+            RankingRecord r;
+            r.seq = seq;
+            r.timestamp = 0;
+            r.entry = e;
+            newer.push_back(r);
+        });
+
+        const BoardEntry* older = boardEntries(m);
+        size_t olderCount = (size_t)boardMap(m).entryCount;
+        size_t i = 0, j = 0;
+        while ((int)result.size() < k && (i < olderCount || j < newer.size())) {
+            // 같은 시간이면 먼저 저장된 board 쪽이 앞
+            if (j >= newer.size() || (i < olderCount && older[i].time <= newer[j].entry.time)) {
+                RankingRecord r;
+                r.seq = older[i].seq;
+                r.timestamp = 0;
+                r.entry.mapType = mapType;
+                r.entry.time = older[i].time;
+                r.entry.name.assign(older[i].name, strnlen(older[i].name, BOARD_NAME_BYTES));
+                result.push_back(r);
+                i++;
+            }
+            else {
+                result.push_back(newer[j++]);
+            }
+        }
+        return result;
+    }
+
+    // 이 시간이 들어갈 순위 (1 부터, 같은 시간은 같은 순위)
+    size_t rank(int mapType, float time) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        int m = slot(mapType);
+        if (m < 0) return 0;
+        const BoardEntry* entries = boardEntries(m);
+        size_t olderCount = (size_t)boardMap(m).entryCount;
+        size_t olderLess = std::lower_bound(entries, entries + olderCount, time,
+            [](const BoardEntry& e, float t) { return e.time < t; }) - entries;
+        return olderLess + recent[m].tree.countLess(time) + 1;
+    }
+
+    // 이름의 최고 기록 (seq 를 주면 그 기록의 seq 도). 기록이 없으면 false.
+    bool personalBest(int mapType, const std::string& name, float* best, uint64_t* seq = NULL) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        int m = slot(mapType);
+        if (m < 0) return false;
+        char key[BOARD_NAME_BYTES];
+        toBoardName(name, key);
+
+        bool found = false;
+        const BoardBest* bests = boardBests(m);
+        size_t bestCount = (size_t)boardMap(m).bestCount;
+        const BoardBest* it = std::lower_bound(bests, bests + bestCount, key,
+            [](const BoardBest& b, const char* k) { return strncmp(b.name, k, BOARD_NAME_BYTES) < 0; });
+        if (it != bests + bestCount && strncmp(it->name, key, BOARD_NAME_BYTES) == 0) {
+            *best = it->time;
+            if (seq) *seq = it->seq;
+            found = true;
+        }
+
+        auto recentIt = recent[m].bests.find(std::string(key));
+        if (recentIt != recent[m].bests.end() && (!found || recentIt->second.time < *best)) {
+            *best = recentIt->second.time;
+            if (seq) *seq = recentIt->second.seq;
+            found = true;
+        }
+        return found;
+    }
+
+private:
+    struct BestRun {
+        float time;
+        uint64_t seq;
+    };
+
+    struct RecentRecords {
+        RankTree tree;
+        std::map<std::string, BestRun> bests;  // board 형식으로 자른 이름 -> 최고 기록
+    };
+
+    static int slot(int mapType) { return (mapType >= 1 && mapType <= LEADERBOARD_MAPS) ? mapType - 1 : -1; }
+
+    static void toBoardName(const std::string& name, char* out) {
+        memset(out, 0, BOARD_NAME_BYTES);
+        memcpy(out, name.data(), std::min(name.size(), (size_t)BOARD_NAME_BYTES - 1));
+    }
+
+    // --- 최근 기록 (board 이후) ---
+    void addRecent(const RankingRecord& r) {
+        int m = slot(r.entry.mapType);
+        if (m < 0) return;
+        recentRecords.push_back(r);
+        indexRecent(r);
+    }
+
+    void indexRecent(const RankingRecord& r) {
+        int m = slot(r.entry.mapType);
+        recent[m].tree.insert(r.entry, r.seq);
+
+        char key[BOARD_NAME_BYTES];
+        toBoardName(r.entry.name, key);
+        BestRun run = { r.entry.time, r.seq };
+        auto it = recent[m].bests.find(key);
+        if (it == recent[m].bests.end()) recent[m].bests.emplace(key, run);
+        else if (r.entry.time < it->second.time) it->second = run;
+    }
+
+    // recentRecords 로 트리/최고 기록을 다시 만든다 (board 가 바뀐 뒤)
+    void rebuildRecent() {
+        for (auto& r : recent) {
+            r.tree.clear();
+            r.bests.clear();
+        }
+        for (const auto& r : recentRecords) indexRecent(r);
+    }
+
+    // --- 쓰기 스레드 ---
+    void writerLoop() {
+        for (;;) {
+            RankingRecord r;
+            while (queue.tryPop(r)) {
+                if (!journal.append(r)) fprintf(stderr, "Rankings: failed to write record %llu\n", (unsigned long long)r.seq);
+            }
+            if (journal.needsCompaction() && journal.compact()) rebuildBoard();
+            if (stopping && queue.empty()) return;
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(RANKING_WRITER_POLL_MS),
+                [this]() { return stopping || !queue.empty(); });
+        }
+    }
+
+    // --- board 파일 ---
+    const BoardHeader* boardHeader() const { return (const BoardHeader*)board->data(); }
+
+    const BoardMapHeader& boardMap(int m) const {
+        static const BoardMapHeader empty = { 0, 0, 0, 0 };
+        return board->data() ? boardHeader()->maps[m] : empty;
+    }
+
+    const BoardEntry* boardEntries(int m) const {
+        return board->data() ? (const BoardEntry*)(board->data() + boardMap(m).entryOffset) : NULL;
+    }
+
+    const BoardBest* boardBests(int m) const {
+        return board->data() ? (const BoardBest*)(board->data() + boardMap(m).bestOffset) : NULL;
+    }
+
+    // 헤더/범위 검사
+    static bool validBoard(const MappedFile& file) {
+        if (file.size() < sizeof(BoardHeader)) return false;
+        const BoardHeader* h = (const BoardHeader*)file.data();
+        if (memcmp(h->magic, "RKBD", 4) != 0 || h->version != BOARD_FORMAT_VERSION) return false;
+        for (int m = 0; m < LEADERBOARD_MAPS; ++m) {
+            const BoardMapHeader& mh = h->maps[m];
+            bool ok = mh.entryOffset % 8 == 0 && mh.bestOffset % 8 == 0
+                && mh.entryOffset <= file.size() && mh.entryCount <= (file.size() - mh.entryOffset) / sizeof(BoardEntry)
+                && mh.bestOffset <= file.size() && mh.bestCount <= (file.size() - mh.bestOffset) / sizeof(BoardBest);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    // path 의 board 를 매핑해서 현재 board 로 바꾸고, 새 board 에 들어간 최근 기록을 뺀다.
+    // 락은 포인터 교체 동안만 잡는다. fromTemp 면 교체 후 임시 파일을 boardPath 로 이름을 바꾼다.
+    bool installBoard(const std::string& path, bool fromTemp) {
+        std::unique_ptr<MappedFile> fresh(new MappedFile());
+        if (!fresh->open(path)) return false;
+        if (!validBoard(*fresh)) {
+            fprintf(stderr, "Rankings: %s is not a valid board, rebuilding\n", path.c_str());
+            return false;
+        }
+        uint64_t lastSeq = ((const BoardHeader*)fresh->data())->lastSeq;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            board.swap(fresh);
+            recentRecords.erase(std::remove_if(recentRecords.begin(), recentRecords.end(),
+                [&](const RankingRecord& r) { return r.seq <= lastSeq; }), recentRecords.end());
+            rebuildRecent();
+        }
+        fresh->close(); // 이전 board (Windows 는 매핑된 파일을 덮어쓸 수 없음)
+        if (fromTemp && !replaceFile(path, boardPath)) {
+            fprintf(stderr, "Rankings: cannot replace %s\n", boardPath.c_str());
+        }
+        return true;
+    }
+
+    // 전체 기록(스냅샷 + 저널)으로 새 board 를 임시 파일에 쓰고 설치한다 (쓰기 스레드 또는 시작 시)
+    bool rebuildBoard() {
+        std::vector<BoardEntry> entries[LEADERBOARD_MAPS];
+        std::map<std::string, BestRun> bests[LEADERBOARD_MAPS];
+        journal.forEachRecord([&](const RankingRecord& r) {
+            int m = slot(r.entry.mapType);
+            if (m < 0) return;
+            BoardEntry e;
+            memset(&e, 0, sizeof(e));
+            e.time = r.entry.time;
+            e.seq = r.seq;
+            toBoardName(r.entry.name, e.name);
+            entries[m].push_back(e);
+
+            BestRun run = { e.time, e.seq };
+            auto it = bests[m].find(e.name);
+            if (it == bests[m].end()) bests[m].emplace(e.name, run);
+            else if (e.time < it->second.time) it->second = run;
+        });
+
+        BoardHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "RKBD", 4);
+        header.version = BOARD_FORMAT_VERSION;
+        header.lastSeq = journal.lastSeq();
+        uint64_t offset = sizeof(BoardHeader);
+        for (int m = 0; m < LEADERBOARD_MAPS; ++m) {
+            std::sort(entries[m].begin(), entries[m].end(), [](const BoardEntry& a, const BoardEntry& b) {
+                return a.time < b.time || (a.time == b.time && a.seq < b.seq);
+            });
+            header.maps[m].entryOffset = offset;
+            header.maps[m].entryCount = entries[m].size();
+            offset += entries[m].size() * sizeof(BoardEntry);
+            header.maps[m].bestOffset = offset;
+            header.maps[m].bestCount = bests[m].size();
+            offset += bests[m].size() * sizeof(BoardBest);
+        }
+
+        std::string tmpPath = boardPath + ".tmp";
+        FILE* out = fopen(tmpPath.c_str(), "wb");
+        if (!out) return false;
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        for (int m = 0; ok && m < LEADERBOARD_MAPS; ++m) {
+            if (!entries[m].empty()) ok = fwrite(entries[m].data(), sizeof(BoardEntry), entries[m].size(), out) == entries[m].size();
+            for (const auto& b : bests[m]) { // std::map 이라 이미 이름순
+                BoardBest best;
+                memset(&best, 0, sizeof(best));
+                memcpy(best.name, b.first.c_str(), b.first.size());
+                best.time = b.second.time;
+                best.seq = b.second.seq;
+                ok = ok && fwrite(&best, sizeof(best), 1, out) == 1;
+            }
+        }
+        ok = ok && fflush(out) == 0;
+        if (ok) syncFile(out);
+        fclose(out);
+
+        if (!ok || !installBoard(tmpPath, true)) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    RankingJournal journal;              // 시작 후에는 쓰기 스레드만 사용
+    std::string boardPath;
+
+    mutable std::mutex mutex;            // board, recent*, nextSeq 보호
+    std::unique_ptr<MappedFile> board;
+    std::vector<RankingRecord> recentRecords;
+    RecentRecords recent[LEADERBOARD_MAPS];
+    uint64_t nextSeq = 1;
+
+    SpscQueue<RankingRecord, RANKING_QUEUE_CAPACITY> queue;
+    std::vector<RankingRecord> pending;  // 큐가 가득 차서 아직 못 넣은 기록 (UI 스레드 전용)
+    std::thread writer;
+    std::atomic<bool> stopping{ false };
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+};
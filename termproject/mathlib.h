@@ -0,0 +1,176 @@
+﻿#pragma once
+// --- CPU 쪽 행렬 / 벡터 수학 ---
+// 카메라, 투영, 모델 행렬을 모두 여기서 만든다. (GL 행렬 스택 / glGetFloatv 를 쓰지 않음)
+// Mat4 는 GL 과 같은 열 우선(column-major) 배열이라 glUniformMatrix4fv, UBO, 인스턴스 버퍼에 그대로 넘긴다.
+// SSE 를 쓸 수 있으면 4x4 곱 / 점 변환을 열 단위 __m128 연산으로 하고, 아니면 같은 계산을 스칼라로 한다.
+// (힙에 잡히는 구조체 안에도 들어가므로 정렬을 가정하지 않고 loadu / storeu 를 씀)
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATHLIB_SSE 1
+#include <xmmintrin.h>
+#else
+#define MATHLIB_SSE 0
+#endif
+
+struct Vec3 {
+    float x, y, z;
+
+    Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+    Vec3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+
+    Vec3 operator+(const Vec3& o) const { return Vec3(x + o.x, y + o.y, z + o.z); }
+    Vec3 operator-(const Vec3& o) const { return Vec3(x - o.x, y - o.y, z - o.z); }
+    Vec3 operator*(float s) const { return Vec3(x * s, y * s, z * s); }
+    Vec3 operator-() const { return Vec3(-x, -y, -z); }
+};
+
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+inline Vec3 cross(const Vec3& a, const Vec3& b) {
+    return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline Vec3 normalize(const Vec3& v) {
+    float len = sqrtf(dot(v, v));
+    return len > 0.0f ? v * (1.0f / len) : v;
+}
+
+// 법선 행렬 등 3x3 (열 우선, glUniformMatrix3fv 로 그대로 전송)
+struct Mat3 {
+    float m[9];
+
+    const float* data() const { return m; }
+};
+
+struct Mat4 {
+    float m[16]; // 열 우선: m[col * 4 + row]
+
+    const float* data() const { return m; }
+    float* data() { return m; }
+
+    static Mat4 identity() {
+        Mat4 r;
+        memset(r.m, 0, sizeof(r.m));
+        r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.0f;
+        return r;
+    }
+
+    static Mat4 translation(float x, float y, float z) {
+        Mat4 r = identity();
+        r.m[12] = x; r.m[13] = y; r.m[14] = z;
+        return r;
+    }
+
+    // Y 축 회전 (자동차 진행 방향)
+    static Mat4 rotationY(float angle) {
+        Mat4 r = identity();
+        float c = cosf(angle);
+        float s = sinf(angle);
+        r.m[0] = c;  r.m[2] = s;
+        r.m[8] = -s; r.m[10] = c;
+        return r;
+    }
+
+    // gluPerspective 와 같은 투영 (fov 는 라디안, 세로 기준)
+    static Mat4 perspective(float fov, float aspect, float nearDist, float farDist) {
+        Mat4 r;
+        memset(r.m, 0, sizeof(r.m));
+        float tanHalfFov = tanf(fov / 2.0f);
+        r.m[0] = 1.0f / (aspect * tanHalfFov);
+        r.m[5] = 1.0f / tanHalfFov;
+        r.m[10] = -(farDist + nearDist) / (farDist - nearDist);
+        r.m[11] = -1.0f;
+        r.m[14] = -(2.0f * farDist * nearDist) / (farDist - nearDist);
+        return r;
+    }
+
+    // gluLookAt 과 같은 view 행렬
+    static Mat4 lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) {
+        Vec3 f = normalize(target - eye);
+        Vec3 s = normalize(cross(f, up));
+        Vec3 u = cross(s, f);
+        Mat4 r = identity();
+        r.m[0] = s.x;  r.m[4] = s.y;  r.m[8] = s.z;
+        r.m[1] = u.x;  r.m[5] = u.y;  r.m[9] = u.z;
+        r.m[2] = -f.x; r.m[6] = -f.y; r.m[10] = -f.z;
+        r.m[12] = -dot(s, eye);
+        r.m[13] = -dot(u, eye);
+        r.m[14] = dot(f, eye);
+        return r;
+    }
+
+    // 결과의 각 열 = 이 행렬의 열들을 o 의 열 성분으로 섞은 것
+    Mat4 operator*(const Mat4& o) const {
+        Mat4 r;
+#if MATHLIB_SSE
+        __m128 c0 = _mm_loadu_ps(m + 0);
+        __m128 c1 = _mm_loadu_ps(m + 4);
+        __m128 c2 = _mm_loadu_ps(m + 8);
+        __m128 c3 = _mm_loadu_ps(m + 12);
+        for (int j = 0; j < 4; ++j) {
+            const float* b = o.m + j * 4;
+            __m128 col = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+            col = _mm_add_ps(col, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+            col = _mm_add_ps(col, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+            col = _mm_add_ps(col, _mm_mul_ps(c3, _mm_set1_ps(b[3])));
+            _mm_storeu_ps(r.m + j * 4, col);
+        }
+#else
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                r.m[j * 4 + i] = m[i] * o.m[j * 4] + m[4 + i] * o.m[j * 4 + 1]
+                               + m[8 + i] * o.m[j * 4 + 2] + m[12 + i] * o.m[j * 4 + 3];
+            }
+        }
+#endif
+        return r;
+    }
+
+    // 왼쪽 위 3x3 (회전 + 이동만 있는 강체 변환이면 이것이 곧 법선 행렬)
+    Mat3 upper3x3() const {
+        Mat3 r;
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) r.m[col * 3 + row] = m[col * 4 + row];
+        }
+        return r;
+    }
+
+    // 법선 행렬 = 왼쪽 위 3x3 의 역행렬의 전치 (비균등 스케일이 있어도 법선이 면에 수직으로 유지됨)
+    // 역행렬의 전치 = 여인수 행렬 / 행렬식 이라 여인수를 바로 채운다.
+    Mat3 normalMatrix() const {
+        const float a = m[0], b = m[4], c = m[8];
+        const float d = m[1], e = m[5], f = m[9];
+        const float g = m[2], h = m[6], i = m[10];
+        float c00 = e * i - f * h, c01 = f * g - d * i, c02 = d * h - e * g;
+        float c10 = c * h - b * i, c11 = a * i - c * g, c12 = b * g - a * h;
+        float c20 = b * f - c * e, c21 = c * d - a * f, c22 = a * e - b * d;
+        float det = a * c00 + b * c01 + c * c02;
+        if (fabsf(det) < 1e-12f) return upper3x3();
+        float inv = 1.0f / det;
+        Mat3 r;
+        r.m[0] = c00 * inv; r.m[3] = c01 * inv; r.m[6] = c02 * inv;
+        r.m[1] = c10 * inv; r.m[4] = c11 * inv; r.m[7] = c12 * inv;
+        r.m[2] = c20 * inv; r.m[5] = c21 * inv; r.m[8] = c22 * inv;
+        return r;
+    }
+
+    // 점 변환 (w = 1)
+    Vec3 transformPoint(const Vec3& p) const {
+#if MATHLIB_SSE
+        __m128 v = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 0), _mm_set1_ps(p.x)),
+                       _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(p.y))),
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(p.z)),
+                       _mm_loadu_ps(m + 12)));
+        float out[4];
+        _mm_storeu_ps(out, v);
+        return Vec3(out[0], out[1], out[2]);
+#else
+        return Vec3(m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+                    m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+                    m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]);
+#endif
+    }
+};
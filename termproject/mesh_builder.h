@@ -0,0 +1,108 @@
+﻿#pragma once
+// --- 인덱스 메시 빌더 ---
+// 기존 11 float (위치, 색, UV, 법선) 정점을 압축 정점으로 바꾸고, 같은 정점은 하나로 합쳐 인덱스로 참조한다.
+// GL 호출 없음 (작업 스레드에서 청크를 만들 때도 사용)
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+
+// 압축 정점 (24바이트, 기존 44바이트)
+struct PackedVertex {
+    float pos[3];       // 위치
+    uint16_t uv[2];     // 텍스처 좌표 (half float)
+    uint32_t normal;    // 법선 (10-10-10-2 signed normalized)
+    uint8_t color[4];   // 색 (RGBA8)
+
+    bool operator==(const PackedVertex& other) const {
+        return memcmp(this, &other, sizeof(PackedVertex)) == 0;
+    }
+};
+
+// float -> half float (반올림)
+inline uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent <= 0) { // half 의 비정규 수 또는 0
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return (uint16_t)(sign | half);
+    }
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00); // 범위 초과 -> inf
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++; // 반올림 (자리 올림은 지수로 넘어가도 올바름)
+    return (uint16_t)half;
+}
+
+// 법선 -> GL_INT_2_10_10_10_REV (x 가 하위 10비트)
+inline uint32_t packNormal(float x, float y, float z) {
+    auto quantize = [](float v) -> uint32_t {
+        if (v > 1.0f) v = 1.0f;
+        if (v < -1.0f) v = -1.0f;
+        return (uint32_t)(int)lroundf(v * 511.0f) & 0x3FF;
+    };
+    return quantize(x) | (quantize(y) << 10) | (quantize(z) << 20);
+}
+
+inline uint8_t packUnorm8(float v) {
+    if (v < 0.0f) v = 0.0f;
+    if (v > 1.0f) v = 1.0f;
+    return (uint8_t)lroundf(v * 255.0f);
+}
+
+struct PackedVertexHash {
+    size_t operator()(const PackedVertex& v) const {
+        // FNV-1a
+        const unsigned char* p = (const unsigned char*)&v;
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(PackedVertex); ++i) { h ^= p[i]; h *= 16777619u; }
+        return h;
+    }
+};
+
+class MeshBuilder {
+public:
+    std::vector<PackedVertex> vertices;
+    std::vector<uint16_t> indices;
+
+    void clear() {
+        vertices.clear();
+        indices.clear();
+        lookup.clear();
+    }
+
+    // 기존 정점 배열과 같은 순서: x, y, z,  r, g, b,  u, v,  nx, ny, nz
+    void add(std::initializer_list<float> v) { add(v.begin()); }
+
+    void add(const float* v) {
+        PackedVertex pv;
+        memset(&pv, 0, sizeof(pv)); // 해시/비교가 바이트 단위이므로 패딩까지 0
+        pv.pos[0] = v[0]; pv.pos[1] = v[1]; pv.pos[2] = v[2];
+        pv.color[0] = packUnorm8(v[3]); pv.color[1] = packUnorm8(v[4]); pv.color[2] = packUnorm8(v[5]); pv.color[3] = 255;
+        pv.uv[0] = floatToHalf(v[6]); pv.uv[1] = floatToHalf(v[7]);
+        pv.normal = packNormal(v[8], v[9], v[10]);
+
+        auto it = lookup.find(pv);
+        if (it != lookup.end()) {
+            indices.push_back(it->second);
+            return;
+        }
+        uint16_t index = (uint16_t)vertices.size();
+        vertices.push_back(pv);
+        lookup.emplace(pv, index);
+        indices.push_back(index);
+    }
+
+private:
+    std::unordered_map<PackedVertex, uint16_t, PackedVertexHash> lookup;
+};
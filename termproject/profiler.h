@@ -0,0 +1,334 @@
+﻿#pragma once
+// --- 프레임 프로파일러 ---
+// PROFILE_SCOPE("이름")       : 스코프가 끝날 때까지의 CPU 시간 측정 (어느 스레드에서나 사용 가능)
+// PROFILE_GPU_SCOPE("이름")   : GL_TIME_ELAPSED 쿼리로 렌더 패스의 GPU 시간 측정 (GL 스레드 전용, 중첩 불가)
+// PROFILE_FRAME_BEGIN()      : 프레임 그리기 시작 표시 (생략하면 직전 프레임 끝부터 잰다)
+// PROFILE_FRAME("태그")       : 프레임 끝 표시 (통계 갱신, 지난 프레임의 GPU 결과 회수)
+//                              태그(화면 상태 등)별로 프레임 수, 그리는 데 쓴 CPU / GPU 시간을 따로 모은다.
+//
+// GPU 쿼리는 PROFILER_GPU_FRAMES 프레임짜리 링으로 돌려서, 몇 프레임 전에 끝난 결과만 읽는다. (파이프라인 대기 없음)
+// ENABLE_PROFILER 를 0 으로 정의하고 빌드하면 매크로가 모두 빈 문장이 된다.
+// GL 헤더(glew)를 먼저 include 한 뒤 include 할 것.
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+#if ENABLE_PROFILER
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <string>
+#include <vector>
+
+const int PROFILER_GPU_FRAMES = 4;        // GPU 쿼리 링 크기 (결과를 읽을 때까지의 지연 프레임 수)
+const int PROFILER_MAX_GPU_PASSES = 16;   // 한 프레임에 측정할 수 있는 GPU 패스 수
+const float PROFILER_SMOOTHING = 0.1f;    // 오버레이용 평균 갱신 비율
+
+class Profiler {
+public:
+    // 오버레이에 보여줄 항목별 평균 (ms)
+    struct Stat {
+        const char* name;
+        float cpuMs;
+        float gpuMs;
+        float lastCpuMs;   // 이번 프레임 합계 (누적 중)
+        double totalCpuMs; // resetTotals() 이후 합계 (벤치마크용)
+        double totalGpuMs;
+        int gpuSamples;
+    };
+
+    // 프레임 태그별 합계. wallMs 는 그 태그로 보낸 실제 시간 (프레임 사이 대기 포함)
+    struct FrameTagStat {
+        const char* name;
+        long long frames;
+        double wallMs;
+        double busyCpuMs;
+        double gpuMs;
+    };
+
+    Profiler() : origin(std::chrono::steady_clock::now()) {}
+
+    double nowUs() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    // --- CPU ---
+    void recordCpu(const char* name, double beginUs, double endUs) {
+        std::lock_guard<std::mutex> lock(mutex);
+        findStat(name).lastCpuMs += (float)((endUs - beginUs) / 1000.0);
+        if (captureFramesLeft > 0) {
+            TraceEvent e = { name, beginUs, endUs - beginUs, threadNumber() };
+            traceEvents.push_back(e);
+        }
+    }
+
+    // --- GPU ---
+    void beginGpu(const char* name) {
+        if (!gpuReady) initGpu();
+        GpuFrame& frame = gpuFrames[gpuFrameIndex];
+        if (frame.passCount >= PROFILER_MAX_GPU_PASSES) { gpuActive = false; return; }
+        frame.names[frame.passCount] = name;
+        glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.passCount]);
+        gpuActive = true;
+    }
+
+    void endGpu() {
+        if (!gpuActive) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuFrames[gpuFrameIndex].passCount++;
+        gpuActive = false;
+    }
+
+    // --- 프레임 ---
+    void beginFrame() {
+        busyBeginUs = nowUs();
+    }
+
+    void endFrame(const char* tag) {
+        double now = nowUs();
+        double busyUs = now - std::max(busyBeginUs, frameBeginUs);
+        frameMs = (float)((now - frameBeginUs) / 1000.0);
+        smoothedFrameMs += (frameMs - smoothedFrameMs) * PROFILER_SMOOTHING;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (gpuReady) {
+            gpuFrames[gpuFrameIndex].tag = tag;
+            collectGpu(now);
+        }
+
+        // 직전 프레임 이후의 시간은 직전 태그로 보낸 시간 (태그는 프레임을 그려야만 바뀌므로)
+        if (frameCount > 0) findTag(lastTag).wallMs += (now - frameBeginUs) / 1000.0;
+        FrameTagStat& t = findTag(tag);
+        t.frames++;
+        t.busyCpuMs += busyUs / 1000.0;
+        lastTag = tag;
+
+        for (auto& s : stats) {
+            s.cpuMs += (s.lastCpuMs - s.cpuMs) * PROFILER_SMOOTHING;
+            s.totalCpuMs += s.lastCpuMs;
+            s.lastCpuMs = 0.0f;
+        }
+        if (captureFramesLeft > 0) {
+            TraceEvent e = { tag, now - busyUs, busyUs, threadNumber() };
+            traceEvents.push_back(e);
+            if (--captureFramesLeft == 0) writeTrace();
+        }
+        frameBeginUs = now;
+        frameCount++;
+    }
+
+    // 다음 frames 프레임을 Chrome trace JSON (chrome://tracing, Perfetto) 으로 저장
+    void captureTrace(int frames, const char* path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        traceEvents.clear();
+        tracePath = path;
+        captureFramesLeft = frames;
+    }
+
+    // 합계 초기화 (벤치마크 워밍업이 끝난 뒤)
+    void resetTotals() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& s : stats) {
+            s.totalCpuMs = 0.0;
+            s.totalGpuMs = 0.0;
+            s.gpuSamples = 0;
+        }
+        frameTags.clear();
+    }
+
+    bool capturing() const { return captureFramesLeft > 0; }
+    float averageFrameMs() const { return smoothedFrameMs; }
+    long long frames() const { return frameCount; }
+
+    // 항목별 평균을 (이름, CPU ms, GPU ms) 로 넘겨준다 (오버레이 출력용)
+    void forEachStat(const std::function<void(const Stat&)>& fn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& s : stats) fn(s);
+    }
+
+    void forEachFrameTag(const std::function<void(const FrameTagStat&)>& fn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& t : frameTags) fn(t);
+    }
+
+    // 태그별 초당 프레임 수와 초당 CPU / GPU 사용 시간 요약 (종료 시 출력용)
+    void printFrameTags(FILE* out) {
+        fprintf(out, "Profiler: frames by tag\n");
+        forEachFrameTag([&](const FrameTagStat& t) {
+            double seconds = std::max(t.wallMs / 1000.0, 1.0e-3);
+            fprintf(out, "  %-10s %7lld frames  %6.1f fps  CPU %7.2f ms/s  GPU %7.2f ms/s\n",
+                t.name, t.frames, t.frames / seconds, t.busyCpuMs / seconds, t.gpuMs / seconds);
+        });
+    }
+
+private:
+    struct TraceEvent {
+        const char* name;
+        double beginUs;
+        double durationUs;
+        int tid;           // 0 은 GPU 트랙
+    };
+
+    struct GpuFrame {
+        GLuint queries[PROFILER_MAX_GPU_PASSES];
+        const char* names[PROFILER_MAX_GPU_PASSES];
+        const char* tag;   // 이 프레임의 태그
+        int passCount;
+        double cpuBeginUs;
+    };
+
+    void initGpu() {
+        for (int f = 0; f < PROFILER_GPU_FRAMES; ++f) {
+            glGenQueries(PROFILER_MAX_GPU_PASSES, gpuFrames[f].queries);
+            gpuFrames[f].passCount = 0;
+            gpuFrames[f].tag = nullptr;
+            gpuFrames[f].cpuBeginUs = frameBeginUs;
+        }
+        gpuReady = true;
+    }
+
+    // 가장 오래된 링 슬롯의 결과를 (준비되었으면) 읽고, 그 슬롯을 이번 프레임용으로 비운다
+    void collectGpu(double now) {
+        gpuFrameIndex = (gpuFrameIndex + 1) % PROFILER_GPU_FRAMES;
+        GpuFrame& frame = gpuFrames[gpuFrameIndex];
+
+        double gpuCursorUs = frame.cpuBeginUs;
+        for (int i = 0; i < frame.passCount; ++i) {
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break; // 아직이면 이번엔 건너뜀 (기다리지 않음)
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &ns);
+            float ms = (float)(ns / 1.0e6);
+
+            Stat& s = findStat(frame.names[i]);
+            s.gpuMs += (ms - s.gpuMs) * PROFILER_SMOOTHING;
+            s.totalGpuMs += ms;
+            s.gpuSamples++;
+            if (frame.tag) findTag(frame.tag).gpuMs += ms;
+
+            // GPU 는 시작 시각을 모르므로 trace 에서는 해당 프레임 시작부터 패스를 이어 붙여 표시
+            if (captureFramesLeft > 0) {
+                TraceEvent e = { frame.names[i], gpuCursorUs, ns / 1000.0, 0 };
+                traceEvents.push_back(e);
+            }
+            gpuCursorUs += ns / 1000.0;
+        }
+        frame.passCount = 0;
+        frame.cpuBeginUs = now;
+    }
+
+    Stat& findStat(const char* name) {
+        for (auto& s : stats) {
+            if (s.name == name || strcmp(s.name, name) == 0) return s;
+        }
+        Stat s = { name, 0.0f, 0.0f, 0.0f, 0.0, 0.0, 0 };
+        stats.push_back(s);
+        return stats.back();
+    }
+
+    FrameTagStat& findTag(const char* name) {
+        for (auto& t : frameTags) {
+            if (t.name == name || strcmp(t.name, name) == 0) return t;
+        }
+        FrameTagStat t = { name, 0, 0.0, 0.0, 0.0 };
+        frameTags.push_back(t);
+        return frameTags.back();
+    }
+
+    // trace 용 스레드 번호 (1 부터, 처음 기록한 순서)
+    int threadNumber() {
+        std::thread::id id = std::this_thread::get_id();
+        for (size_t i = 0; i < threadIds.size(); ++i) {
+            if (threadIds[i] == id) return (int)i + 1;
+        }
+        threadIds.push_back(id);
+        return (int)threadIds.size();
+    }
+
+    void writeTrace() {
+        FILE* file = fopen(tracePath.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "Profiler: cannot write %s\n", tracePath.c_str());
+            return;
+        }
+        fprintf(file, "{\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}");
+        for (size_t i = 0; i < threadIds.size(); ++i) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}",
+                (int)i + 1, (int)i + 1);
+        }
+        for (const auto& e : traceEvents) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                e.name, e.tid, e.beginUs, e.durationUs);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        printf("Profiler: wrote %d events to %s\n", (int)traceEvents.size(), tracePath.c_str());
+        traceEvents.clear();
+    }
+
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex;
+    std::vector<Stat> stats;
+    std::vector<std::thread::id> threadIds;
+    std::vector<FrameTagStat> frameTags;
+    const char* lastTag = nullptr;
+
+    double frameBeginUs = 0.0;
+    double busyBeginUs = 0.0;
+    float frameMs = 0.0f;
+    float smoothedFrameMs = 0.0f;
+    long long frameCount = 0;
+
+    GpuFrame gpuFrames[PROFILER_GPU_FRAMES];
+    int gpuFrameIndex = 0;
+    bool gpuReady = false;
+    bool gpuActive = false;
+
+    std::vector<TraceEvent> traceEvents;
+    std::string tracePath;
+    int captureFramesLeft = 0;
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// 스코프 CPU 타이머
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* scopeName) : name(scopeName), beginUs(profiler().nowUs()) {}
+    ~ProfileScope() { profiler().recordCpu(name, beginUs, profiler().nowUs()); }
+private:
+    const char* name;
+    double beginUs;
+};
+
+// 스코프 GPU 타이머
+class ProfileGpuScope {
+public:
+    explicit ProfileGpuScope(const char* name) { profiler().beginGpu(name); }
+    ~ProfileGpuScope() { profiler().endGpu(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) ProfileGpuScope PROFILE_CONCAT(profileGpuScope, __LINE__)(name)
+#define PROFILE_FRAME_BEGIN() profiler().beginFrame()
+#define PROFILE_FRAME(tag) profiler().endFrame(tag)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#define PROFILE_FRAME_BEGIN() ((void)0)
+#define PROFILE_FRAME(tag) ((void)0)
+
+#endif
@@ -0,0 +1,138 @@
+﻿#pragma once
+// --- 쉐이더 프로그램 바이너리 캐시 ---
+// 링크된 프로그램을 glGetProgramBinary 로 받아 shader_cache/<키>.bin 에 저장해 두고,
+// 다음 실행에서 같은 키면 glProgramBinary 로 컴파일 없이 바로 불러온다.
+// 키 = FNV-1a 64 (쉐이더 소스 + GL_VENDOR / GL_RENDERER / GL_VERSION) 이라 소스나 드라이버가 바뀌면 자동으로 새로 만든다.
+// 드라이버가 바이너리를 거부하면 (링크 실패) 파일을 지우고 0 을 돌려주므로 호출한 쪽에서 소스 컴파일로 넘어가면 된다.
+// GL 헤더(glew)를 먼저 include 한 뒤 include 할 것.
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const uint32_t PROGRAM_CACHE_MAGIC = 0x42504C47; // "GLPB"
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+class ProgramCache {
+public:
+    explicit ProgramCache(const char* directory = "shader_cache") : dir(directory) {}
+
+    // 드라이버가 바이너리 형식을 하나라도 지원하는지 (GL 4.1 / ARB_get_program_binary)
+    bool supported() const {
+        if (!GLEW_ARB_get_program_binary) return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    uint64_t key(const std::string& vSrc, const std::string& fSrc) const {
+        uint64_t h = 14695981039346656037ULL;
+        hashString(h, vSrc.c_str());
+        hashString(h, fSrc.c_str());
+        hashString(h, (const char*)glGetString(GL_VENDOR));
+        hashString(h, (const char*)glGetString(GL_RENDERER));
+        hashString(h, (const char*)glGetString(GL_VERSION));
+        return h;
+    }
+
+    // 캐시에 있으면 링크된 프로그램, 없거나 드라이버가 거부하면 0
+    GLuint tryLoad(uint64_t k) const {
+        if (!supported()) return 0;
+        std::string path = pathFor(k);
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return 0;
+
+        Header header;
+        std::vector<char> binary;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1
+            && header.magic == PROGRAM_CACHE_MAGIC && header.version == PROGRAM_CACHE_VERSION
+            && header.key == k && header.length > 0;
+        if (ok) {
+            binary.resize(header.length);
+            ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+        }
+        fclose(file);
+        if (!ok) {
+            remove(path.c_str());
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, (GLenum)header.format, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            // 드라이버 업데이트 등으로 형식이 맞지 않음 -> 다시 컴파일해서 덮어쓰게 함
+            fprintf(stderr, "Shader cache: binary rejected, recompiling (%s)\n", path.c_str());
+            glDeleteProgram(program);
+            remove(path.c_str());
+            return 0;
+        }
+        return program;
+    }
+
+    // 링크가 끝난 프로그램을 저장 (링크 전에 GL_PROGRAM_BINARY_RETRIEVABLE_HINT 를 켜 둘 것)
+    bool store(uint64_t k, GLuint program) const {
+        if (!supported()) return false;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return false;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0) return false;
+
+        makeDirectory();
+        std::string path = pathFor(k);
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        Header header = { PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, k, (uint32_t)format, (uint32_t)written };
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(binary.data(), 1, written, file) == (size_t)written;
+        ok = (fclose(file) == 0) && ok;
+        if (!ok) remove(path.c_str()); // 반쯤 쓴 파일은 남기지 않음
+        return ok;
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    static void hashString(uint64_t& h, const char* s) {
+        if (!s) s = "";
+        for (; *s; ++s) {
+            h ^= (unsigned char)*s;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xFF; // 구분자 (문자열 경계가 달라도 같은 키가 나오지 않게)
+        h *= 1099511628211ULL;
+    }
+
+    std::string pathFor(uint64_t k) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)k);
+        return dir + "/" + name;
+    }
+
+    void makeDirectory() const {
+#ifdef _WIN32
+        _mkdir(dir.c_str());
+#else
+        mkdir(dir.c_str(), 0755);
+#endif
+    }
+
+    std::string dir;
+};
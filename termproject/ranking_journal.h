@@ -0,0 +1,378 @@
+﻿#pragma once
+// --- 랭킹 저널 ---
+// 완주 기록을 모두 rankings.log 에 덧붙여 쓰고(체크섬 포함), 시작할 때 읽어서 색인(leaderboard.h)을 만든다.
+// 저널이 길어지면 전체 기록을 rankings.snapshot 으로 압축한다. (임시 파일에 쓴 뒤 이름 바꾸기)
+// 쓰다가 죽어도 마지막 레코드만 잃는다. 체크섬이 맞지 않는 꼬리는 무시하고 다음 압축 때 정리된다.
+//
+// 레코드 (리틀 엔디언): uint32 payload 크기, uint32 CRC-32(payload),
+//   payload = uint64 seq, int64 timestamp, float time, uint8 map, uint8 이름 길이, 이름
+// 스냅샷 헤더: "RKSN", uint32 버전, uint64 마지막 seq (저널에서 이 이하의 seq 는 이미 스냅샷에 있음)
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#ifdef _WIN32
+#include <io.h>
+extern "C" __declspec(dllimport) int __stdcall MoveFileExA(const char* existingName, const char* newName, unsigned long flags);
+#else
+#include <unistd.h>
+#endif
+
+const int RANKING_COMPACT_THRESHOLD = 256;   // 저널 레코드가 이만큼 쌓이면 스냅샷으로 압축
+const uint32_t RANKING_FORMAT_VERSION = 1;
+const size_t RANKING_MAX_NAME = 255;
+
+// 랭킹 구조체
+struct RankingEntry {
+    int mapType;
+    float time;
+    std::string name;
+
+    bool operator<(const RankingEntry& other) const {
+        return time < other.time;
+    }
+};
+
+// 저널에 남는 완주 기록 한 건
+struct RankingRecord {
+    uint64_t seq;
+    int64_t timestamp;   // 저장 시각 (unix 초, 예전 rankings.txt 에서 가져온 기록은 0)
+    RankingEntry entry;
+};
+
+// 새 완주 기록 (저장 시각은 지금)
+inline RankingRecord makeRankingRecord(uint64_t seq, int mapType, float time, const std::string& name) {
+    RankingRecord r;
+    r.seq = seq;
+    r.timestamp = (int64_t)::time(NULL);
+    r.entry.mapType = mapType;
+    r.entry.time = time;
+    r.entry.name = name.empty() ? "Anonymous" : name.substr(0, RANKING_MAX_NAME);
+    return r;
+}
+
+// CRC-32 (IEEE) 조회 표
+struct Crc32Table {
+    uint32_t entries[256];
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+inline uint32_t crc32(const unsigned char* data, size_t size) {
+    static const Crc32Table table;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// 디스크까지 내려쓰기
+inline void syncFile(FILE* file) {
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+// 임시 파일로 대상 파일을 원자적으로 교체
+inline bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    const unsigned long MOVEFILE_REPLACE_EXISTING_FLAG = 0x1, MOVEFILE_WRITE_THROUGH_FLAG = 0x8;
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING_FLAG | MOVEFILE_WRITE_THROUGH_FLAG) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+class RankingJournal {
+public:
+    explicit RankingJournal(const std::string& basePath = "rankings")
+        : journalPath(basePath + ".log"), snapshotPath(basePath + ".snapshot"), legacyPath(basePath + ".txt") {}
+
+    ~RankingJournal() { closeJournal(); }
+
+    RankingJournal(const RankingJournal&) = delete;
+    RankingJournal& operator=(const RankingJournal&) = delete;
+
+    // 스냅샷 + 저널에서 seq 가 afterSeq 보다 큰 기록에 fn 을 호출한다.
+    // (색인 파일에 이미 들어 있는 기록은 다시 읽지 않도록 afterSeq 로 건너뜀)
+    // 둘 다 없으면 예전 rankings.txt 를 가져온다.
+    void load(uint64_t afterSeq, const std::function<void(const RankingRecord&)>& fn) {
+        closeJournal();
+        snapshotSeq = 0;
+        nextSeq = 1;
+        journalRecords = 0;
+
+        auto newer = [&](const RankingRecord& r) { if (r.seq > afterSeq) fn(r); };
+        bool hasSnapshot = readSnapshot(nullptr);
+        if (hasSnapshot && snapshotSeq > afterSeq) readSnapshot(newer);
+        bool journalTorn = false;
+        bool hasJournal = readJournal(newer, &journalTorn);
+
+        if (!hasSnapshot && !hasJournal) {
+            importLegacy(fn);
+            return;
+        }
+        // 잘린 꼬리 뒤에 덧붙이면 그 뒤 레코드를 못 읽으므로 바로 정리
+        if (journalTorn) compact();
+    }
+
+    // 완주 기록 한 건 추가 (파일 끝에 덧붙이기만 함). seq 는 lastSeq() 보다 커야 한다.
+    bool append(const RankingRecord& r) {
+        if (!openJournal()) return false;
+        std::vector<unsigned char> bytes;
+        encode(r, bytes);
+        if (fwrite(bytes.data(), 1, bytes.size(), journal) != bytes.size()) return false;
+        syncFile(journal);
+
+        if (r.seq >= nextSeq) nextSeq = r.seq + 1;
+        journalRecords++;
+        return true;
+    }
+
+    // 저널이 길어져서 압축할 때가 되었는지
+    bool needsCompaction() const { return journalRecords >= RANKING_COMPACT_THRESHOLD; }
+
+    // 마지막으로 저장된 기록의 seq (없으면 0)
+    uint64_t lastSeq() const { return nextSeq - 1; }
+
+    // 스냅샷 + 저널의 모든 기록을 새 스냅샷 하나로 합치고 저널을 비운다
+    bool compact() {
+        closeJournal();
+        std::string tmpPath = snapshotPath + ".tmp";
+        FILE* out = fopen(tmpPath.c_str(), "wb");
+        if (!out) return false;
+
+        uint64_t lastSeq = nextSeq - 1;
+        writeSnapshotHeader(out, lastSeq);
+        std::vector<unsigned char> bytes;
+        bool ok = true;
+        auto copy = [&](const RankingRecord& r) {
+            bytes.clear();
+            encode(r, bytes);
+            if (fwrite(bytes.data(), 1, bytes.size(), out) != bytes.size()) ok = false;
+        };
+        readSnapshot(copy);
+        readJournal(copy, NULL);
+        ok = ok && fflush(out) == 0;
+        if (ok) syncFile(out);
+        fclose(out);
+        if (!ok || !replaceFile(tmpPath, snapshotPath)) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+        snapshotSeq = lastSeq;
+
+        // 여기서 죽어도 저널의 seq 가 스냅샷 seq 이하라서 다시 읽을 때 건너뜀
+        FILE* reset = fopen(journalPath.c_str(), "wb");
+        if (reset) {
+            writeJournalHeader(reset);
+            syncFile(reset);
+            fclose(reset);
+        }
+        journalRecords = 0;
+        return true;
+    }
+
+    // 전체 기록을 저장 순서대로 읽는다 (분석용, 메모리에 모두 올리지 않음)
+    void forEachRecord(const std::function<void(const RankingRecord&)>& fn) {
+        if (journal) fflush(journal);
+        readSnapshot(fn);
+        readJournal(fn, NULL);
+    }
+
+private:
+
+    // --- 레코드 인코딩 ---
+    static void put(std::vector<unsigned char>& out, const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        out.insert(out.end(), p, p + size);
+    }
+
+    static void encode(const RankingRecord& r, std::vector<unsigned char>& out) {
+        std::vector<unsigned char> payload;
+        uint8_t map = (uint8_t)r.entry.mapType;
+        uint8_t nameLength = (uint8_t)std::min(r.entry.name.size(), RANKING_MAX_NAME);
+        put(payload, &r.seq, sizeof(r.seq));
+        put(payload, &r.timestamp, sizeof(r.timestamp));
+        put(payload, &r.entry.time, sizeof(r.entry.time));
+        put(payload, &map, 1);
+        put(payload, &nameLength, 1);
+        put(payload, r.entry.name.data(), nameLength);
+
+        uint32_t size = (uint32_t)payload.size();
+        uint32_t crc = crc32(payload.data(), payload.size());
+        put(out, &size, sizeof(size));
+        put(out, &crc, sizeof(crc));
+        put(out, payload.data(), payload.size());
+    }
+
+    // 레코드 하나 읽기. 파일 끝이거나 잘렸거나 체크섬이 틀리면 false.
+    static bool readRecord(FILE* file, RankingRecord& r) {
+        uint32_t size, crc;
+        if (fread(&size, sizeof(size), 1, file) != 1) return false;
+        if (fread(&crc, sizeof(crc), 1, file) != 1) return false;
+        const uint32_t fixedSize = sizeof(uint64_t) + sizeof(int64_t) + sizeof(float) + 2;
+        if (size < fixedSize || size > fixedSize + RANKING_MAX_NAME) return false;
+
+        unsigned char payload[fixedSize + RANKING_MAX_NAME];
+        if (fread(payload, 1, size, file) != size) return false;
+        if (crc32(payload, size) != crc) return false;
+
+        const unsigned char* p = payload;
+        memcpy(&r.seq, p, sizeof(r.seq)); p += sizeof(r.seq);
+        memcpy(&r.timestamp, p, sizeof(r.timestamp)); p += sizeof(r.timestamp);
+        memcpy(&r.entry.time, p, sizeof(r.entry.time)); p += sizeof(r.entry.time);
+        r.entry.mapType = *p++;
+        uint8_t nameLength = *p++;
+        if (fixedSize + nameLength != size) return false;
+        r.entry.name.assign((const char*)p, nameLength);
+        return true;
+    }
+
+    // --- 파일 ---
+    static void writeJournalHeader(FILE* file) {
+        fwrite("RKLG", 1, 4, file);
+        fwrite(&RANKING_FORMAT_VERSION, sizeof(uint32_t), 1, file);
+    }
+
+    static void writeSnapshotHeader(FILE* file, uint64_t lastSeq) {
+        fwrite("RKSN", 1, 4, file);
+        fwrite(&RANKING_FORMAT_VERSION, sizeof(uint32_t), 1, file);
+        fwrite(&lastSeq, sizeof(lastSeq), 1, file);
+    }
+
+    static bool readHeader(FILE* file, const char* magic) {
+        char buf[4];
+        uint32_t version;
+        if (fread(buf, 1, 4, file) != 4 || memcmp(buf, magic, 4) != 0) return false;
+        if (fread(&version, sizeof(version), 1, file) != 1) return false;
+        return version == RANKING_FORMAT_VERSION;
+    }
+
+    // 스냅샷의 모든 레코드에 fn 호출 (fn 이 NULL 이면 헤더만 읽음). 스냅샷이 없으면 false.
+    bool readSnapshot(const std::function<void(const RankingRecord&)>& fn) {
+        FILE* file = fopen(snapshotPath.c_str(), "rb");
+        if (!file) return false;
+        uint64_t lastSeq = 0;
+        if (!readHeader(file, "RKSN") || fread(&lastSeq, sizeof(lastSeq), 1, file) != 1) {
+            fclose(file);
+            fprintf(stderr, "Rankings: %s is not a valid snapshot, ignored\n", snapshotPath.c_str());
+            return false;
+        }
+        snapshotSeq = lastSeq;
+        if (nextSeq <= lastSeq) nextSeq = lastSeq + 1;
+
+        RankingRecord r;
+        while (fn && readRecord(file, r)) fn(r);
+        fclose(file);
+        return true;
+    }
+
+    // 저널에서 스냅샷 이후의 레코드에 fn 호출. 저널이 없으면 false.
+    // torn 이 주어지면 파일 끝 전에 읽기를 멈췄는지(잘린 꼬리) 알려준다.
+    bool readJournal(const std::function<void(const RankingRecord&)>& fn, bool* torn) {
+        FILE* file = fopen(journalPath.c_str(), "rb");
+        if (!file) return false;
+        if (torn) *torn = false;
+        if (!readHeader(file, "RKLG")) {
+            fclose(file);
+            if (torn) *torn = true;
+            return true;
+        }
+
+        RankingRecord r;
+        long valid = ftell(file);
+        int count = 0;
+        while (readRecord(file, r)) {
+            valid = ftell(file);
+            if (r.seq <= snapshotSeq) continue;
+            if (r.seq >= nextSeq) nextSeq = r.seq + 1;
+            fn(r);
+            count++;
+        }
+        if (torn) {
+            fseek(file, 0, SEEK_END);
+            *torn = ftell(file) != valid;
+            journalRecords = count;
+        }
+        fclose(file);
+        return true;
+    }
+
+    // 예전 형식 rankings.txt ("<맵> <시간> <이름>" 한 줄씩) 을 가져와 스냅샷으로 저장
+    void importLegacy(const std::function<void(const RankingRecord&)>& fn) {
+        std::ifstream file(legacyPath.c_str());
+        if (!file.is_open()) return;
+
+        std::string line;
+        std::vector<RankingRecord> imported;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            int mapType;
+            float time;
+            std::string name;
+            if (!(iss >> mapType >> time)) continue;
+            std::getline(iss, name);
+            if (!name.empty() && name[0] == ' ') name = name.substr(1);
+
+            RankingRecord r;
+            r.seq = nextSeq++;
+            r.timestamp = 0;
+            r.entry.mapType = mapType;
+            r.entry.time = time;
+            r.entry.name = name.empty() ? "Anonymous" : name.substr(0, RANKING_MAX_NAME);
+            imported.push_back(r);
+            fn(r);
+        }
+        if (imported.empty()) return;
+
+        // 가져온 기록을 저널에 쓰고 바로 스냅샷으로 압축 (다음 실행부터는 rankings.txt 를 읽지 않음)
+        if (openJournal()) {
+            std::vector<unsigned char> bytes;
+            for (const auto& r : imported) {
+                bytes.clear();
+                encode(r, bytes);
+                fwrite(bytes.data(), 1, bytes.size(), journal);
+            }
+            syncFile(journal);
+            compact();
+        }
+        printf("Rankings: imported %d records from %s\n", (int)imported.size(), legacyPath.c_str());
+    }
+
+    bool openJournal() {
+        if (journal) return true;
+        journal = fopen(journalPath.c_str(), "ab");
+        if (!journal) return false;
+        fseek(journal, 0, SEEK_END);
+        if (ftell(journal) == 0) writeJournalHeader(journal);
+        return true;
+    }
+
+    void closeJournal() {
+        if (journal) fclose(journal);
+        journal = NULL;
+    }
+
+    std::string journalPath;
+    std::string snapshotPath;
+    std::string legacyPath;
+    FILE* journal = NULL;
+
+    uint64_t snapshotSeq = 0;
+    uint64_t nextSeq = 1;
+    int journalRecords = 0;
+};
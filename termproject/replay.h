@@ -0,0 +1,325 @@
+﻿#pragma once
+// --- 리플레이 (입력 녹화 / 재생) ---
+// 레이스의 틱별 방향키 상태를 run-length 로 저장한다. 시뮬레이션은 결정적이므로 (고정 틱, 틱 수 기반 타이머)
+// 같은 맵 / 틱 주기 / 도로 길이로 입력만 다시 넣으면 같은 레이스가 그대로 재현된다.
+//
+// 파일 (.rpl, 리틀 엔디언): ReplayHeader 뒤에 run 목록.
+//   run = varint((틱 수 << 4) | 키 마스크). 키 상태가 바뀔 때마다 하나라서 보통 레이스 하나가 수백 바이트.
+// buildHash 는 시뮬레이션 규칙(상수 + SIMULATION_RULES_VERSION)으로 만든 값이다.
+// 규칙이 다른 빌드에서 녹화한 리플레이는 compatible() 이 false 라 재생 / 검증 전에 걸러낸다.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "simulation.h"
+#include "ranking_journal.h"   // crc32, replaceFile
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const uint32_t REPLAY_MAGIC = 0x594C5052;  // "RPLY"
+const uint32_t REPLAY_VERSION = 1;
+const char* const REPLAY_DIRECTORY = "replays";
+
+enum ReplayKey { REPLAY_KEY_UP = 1, REPLAY_KEY_DOWN = 2, REPLAY_KEY_LEFT = 4, REPLAY_KEY_RIGHT = 8 };
+
+inline uint8_t packInput(const CarInput& in) {
+    return (uint8_t)((in.up ? REPLAY_KEY_UP : 0) | (in.down ? REPLAY_KEY_DOWN : 0)
+        | (in.left ? REPLAY_KEY_LEFT : 0) | (in.right ? REPLAY_KEY_RIGHT : 0));
+}
+
+inline CarInput unpackInput(uint8_t keys) {
+    CarInput in;
+    in.up = (keys & REPLAY_KEY_UP) != 0;
+    in.down = (keys & REPLAY_KEY_DOWN) != 0;
+    in.left = (keys & REPLAY_KEY_LEFT) != 0;
+    in.right = (keys & REPLAY_KEY_RIGHT) != 0;
+    return in;
+}
+
+// 이 빌드의 시뮬레이션 규칙 해시 (FNV-1a 64)
+inline uint64_t simulationBuildHash() {
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ULL;
+        }
+    };
+    const float constants[] = { ROAD_WIDTH, CAR_COLLISION_RADIUS, TRACK_START_Z, FINISH_LINE_MARGIN,
+                                CAR_SPEED, CAR_ROT_SPEED, TRACK_SAMPLE_SPACING, TRACK_SAMPLE_MARGIN };
+    mix(constants, sizeof(constants));
+    mix(&SIMULATION_RULES_VERSION, sizeof(SIMULATION_RULES_VERSION));
+    return h;
+}
+
+struct ReplayHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t buildHash;
+    int32_t mapType;
+    int32_t simHz;
+    float trackLength;
+    uint32_t result;      // StepResult (녹화가 끝난 이유)
+    uint64_t ticks;       // 녹화한 틱 수
+    int32_t elapsedMs;    // 레이스 타이머 기록
+    uint32_t runCount;
+    uint32_t dataBytes;   // 헤더 뒤 run 목록 크기
+    uint32_t dataCrc;     // run 목록 CRC-32
+};
+static_assert(sizeof(ReplayHeader) == 56, "ReplayHeader layout");
+
+// 헤더 검사. 문제가 없으면 NULL, 있으면 이유
+inline const char* checkReplayHeader(const ReplayHeader& h) {
+    if (h.magic != REPLAY_MAGIC || h.version != REPLAY_VERSION) return "not a replay file";
+    if (h.mapType != 1 && h.mapType != 2) return "unknown map";
+    if (h.simHz <= 0 || !(h.trackLength > FINISH_LINE_MARGIN)) return "bad header";
+    return NULL;
+}
+
+// varint (LEB128): 7 비트씩, 뒤에 더 있으면 최상위 비트 1
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// 읽은 바이트 수 (잘렸거나 너무 길면 0)
+inline size_t readVarint(const uint8_t* data, size_t size, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < size && i < 10; ++i) {
+        value |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) return i + 1;
+    }
+    return 0;
+}
+
+inline void makeReplayDirectory() {
+#ifdef _WIN32
+    _mkdir(REPLAY_DIRECTORY);
+#else
+    mkdir(REPLAY_DIRECTORY, 0755);
+#endif
+}
+
+// 랭킹 기록 seq 에 딸린 리플레이 경로 (replays/<seq>.rpl)
+inline std::string replayPathForSeq(uint64_t seq) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%llu.rpl", REPLAY_DIRECTORY, (unsigned long long)seq);
+    return name;
+}
+
+class Replay {
+public:
+    Replay() { begin(1, DEFAULT_SIM_HZ, DEFAULT_TRACK_LENGTH); }
+
+    // --- 녹화 ---
+    void begin(int mapType, int simHz, float trackLength) {
+        memset(&header, 0, sizeof(header));
+        header.magic = REPLAY_MAGIC;
+        header.version = REPLAY_VERSION;
+        header.buildHash = simulationBuildHash();
+        header.mapType = mapType;
+        header.simHz = simHz;
+        header.trackLength = trackLength;
+        header.result = STEP_RUNNING;
+        data.clear();
+        runKeys = 0;
+        runLength = 0;
+    }
+
+    // 한 틱의 입력
+    void record(const CarInput& in) {
+        uint8_t keys = packInput(in);
+        if (runLength > 0 && keys != runKeys) flushRun();
+        runKeys = keys;
+        runLength++;
+        header.ticks++;
+    }
+
+    void finish(StepResult result, int elapsedMs) {
+        if (runLength > 0) flushRun();
+        header.result = (uint32_t)result;
+        header.elapsedMs = elapsedMs;
+        header.dataBytes = (uint32_t)data.size();
+        header.dataCrc = crc32(data.data(), data.size());
+    }
+
+    // 임시 파일에 쓴 뒤 이름 바꾸기 (반쯤 쓴 리플레이를 남기지 않음)
+    bool save(const std::string& path) const {
+        makeReplayDirectory();
+        std::string tmp = path + ".tmp";
+        FILE* file = fopen(tmp.c_str(), "wb");
+        if (!file) return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && (data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size());
+        ok = (fclose(file) == 0) && ok;
+        if (!ok || !replaceFile(tmp.c_str(), path.c_str())) {
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // --- 불러오기 ---
+    bool load(const std::string& path, std::string* error = NULL) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return fail(error, "cannot open");
+        ReplayHeader h;
+        bool ok = fread(&h, sizeof(h), 1, file) == 1;
+        const char* bad = ok ? checkReplayHeader(h) : NULL;
+        if (bad) {
+            fclose(file);
+            return fail(error, bad);
+        }
+        std::vector<uint8_t> bytes;
+        if (ok) {
+            bytes.resize(h.dataBytes);
+            ok = bytes.empty() || fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        }
+        fclose(file);
+        if (!ok) return fail(error, "truncated");
+        if (crc32(bytes.data(), bytes.size()) != h.dataCrc) return fail(error, "checksum mismatch");
+        header = h;
+        data.swap(bytes);
+        return true;
+    }
+
+    // 이 빌드의 규칙으로 녹화된 리플레이인지
+    bool compatible() const { return header.buildHash == simulationBuildHash(); }
+
+    ReplayHeader header;
+    std::vector<uint8_t> data;   // run 목록
+
+private:
+    void flushRun() {
+        writeVarint(data, (runLength << 4) | runKeys);
+        header.runCount++;
+        runLength = 0;
+    }
+
+    static bool fail(std::string* error, const char* message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    uint8_t runKeys = 0;
+    uint64_t runLength = 0;
+};
+
+// 재생: 틱마다 입력을 하나씩 꺼낸다
+class ReplayCursor {
+public:
+    ReplayCursor() {}
+    explicit ReplayCursor(const Replay& r) { reset(r); }
+
+    void reset(const Replay& r) {
+        data = r.data.data();
+        size = r.data.size();
+        rewind();
+    }
+
+    void rewind() {
+        offset = 0;
+        runLeft = 0;
+        keys = 0;
+        ticks = 0;
+    }
+
+    // 다음 틱 입력. 녹화가 끝났으면 false
+    bool next(CarInput& out) {
+        while (runLeft == 0) {
+            if (offset >= size) return false;
+            uint64_t run = 0;
+            size_t used = readVarint(data + offset, size - offset, run);
+            if (used == 0) { offset = size; return false; }
+            offset += used;
+            keys = (uint8_t)(run & 0x0F);
+            runLeft = run >> 4;
+        }
+        runLeft--;
+        ticks++;
+        out = unpackInput(keys);
+        return true;
+    }
+
+    uint64_t tick() const { return ticks; }
+
+private:
+    const uint8_t* data = NULL;
+    size_t size = 0;
+    size_t offset = 0;
+    uint64_t runLeft = 0;
+    uint8_t keys = 0;
+    uint64_t ticks = 0;
+};
+
+// 재생 결과
+struct ReplayOutcome {
+    StepResult result;
+    long long ticks;
+    int elapsedMs;
+    CarState state;
+};
+
+// 빨리 감기: 화면 없이 녹화된 입력 그대로 끝까지 시뮬레이션 (레이스 하나에 수 ms 이하)
+inline ReplayOutcome simulateReplay(const Replay& replay) {
+    ReplayOutcome out;
+    resetCar(out.state, replay.header.mapType, replay.header.trackLength);
+    float dt = 1.0f / replay.header.simHz;
+    out.result = STEP_RUNNING;
+    out.ticks = 0;
+
+    ReplayCursor cursor(replay);
+    CarInput in;
+    while (out.result == STEP_RUNNING && cursor.next(in)) {
+        out.result = stepCar(out.state, in, dt);
+        out.ticks++;
+    }
+    out.elapsedMs = out.state.elapsedTime;
+    return out;
+}
+
+inline const char* stepResultName(StepResult result) {
+    return (result == STEP_FINISHED) ? "FINISH" : (result == STEP_CRASHED) ? "CRASH" : "INCOMPLETE";
+}
+
+// --- 기록 검증 ---
+// 주장한 기록(맵, 시간)을 리플레이로 다시 달려 확인한다. stepCar 는 updateCar 가 쓰는 것과 같은 함수라
+// 충돌(도로 중심과의 거리 > ROAD_WIDTH / 2 - CAR_COLLISION_RADIUS) / 피니시라인 판정이 게임과 똑같다.
+// 순위는 기본 도로 길이에서만 비교할 수 있고, 틱 주기가 낮으면 한 틱에 인도를 건너뛸 수 있어 둘 다 거부한다.
+// 부르기 전에 prepareTrackSamplers(DEFAULT_TRACK_LENGTH) 를 해 둘 것 (여러 스레드에서 표를 읽기만 함)
+struct ReplayVerification {
+    bool accepted;
+    const char* reason;     // 거부 이유 (통과면 NULL)
+    ReplayOutcome outcome;  // 다시 달린 결과 (규칙 검사에서 거부되면 비어 있음)
+};
+
+inline ReplayVerification verifyReplay(const Replay& replay, int mapType, int claimedMs) {
+    ReplayVerification v;
+    v.accepted = false;
+    v.reason = NULL;
+    v.outcome.result = STEP_RUNNING;
+    v.outcome.ticks = 0;
+    v.outcome.elapsedMs = 0;
+
+    const ReplayHeader& h = replay.header;
+    if (!replay.compatible()) v.reason = "different simulation rules";
+    else if (h.mapType != mapType) v.reason = "wrong map";
+    else if (h.trackLength != DEFAULT_TRACK_LENGTH) v.reason = "non-standard track length";
+    else if (h.simHz < DEFAULT_SIM_HZ) v.reason = "tick rate too low";
+    if (v.reason) return v;
+
+    v.outcome = simulateReplay(replay);
+    if (v.outcome.result == STEP_CRASHED) v.reason = "crashed";
+    else if (v.outcome.result != STEP_FINISHED) v.reason = "did not finish";
+    else if (v.outcome.elapsedMs != claimedMs) v.reason = "time mismatch";
+    v.accepted = (v.reason == NULL);
+    return v;
+}
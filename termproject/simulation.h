@@ -0,0 +1,364 @@
+﻿#pragma once
+// --- 시뮬레이션 코어 ---
+// 자동차 이동, 충돌, 피니시라인, 타이머 로직만 담는다.
+// GL/GLUT 에 의존하지 않으므로 창이나 GL 컨텍스트 없이도 돌릴 수 있다. (헤드리스 모드)
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <vector>
+#include <mutex>
+#include "track_curve.h"
+
+// 도로 설정
+const float ROAD_WIDTH = 2.0f;       // 도로 전체 폭
+const float SIDEWALK_WIDTH = 1.5f;   // 인도 폭
+const float CAR_COLLISION_RADIUS = 0.5f; // 자동차 충돌 반경
+const float TRACK_START_Z = 20.0f;           // 도로 시작 위치
+const float DEFAULT_TRACK_LENGTH = 500.0f;   // 기본 도로 길이 (z = 20 ~ -500)
+const float FINISH_LINE_MARGIN = 5.0f;       // 도로 끝에서 피니시라인까지 거리
+const float FINISH_LINE_Z = -495.0f; // 기본 트랙의 피니시라인 위치
+
+// 도로 길이에 따른 피니시라인 위치
+inline float getFinishLineZ(float trackLength) {
+    return -trackLength + FINISH_LINE_MARGIN;
+}
+
+// 자동차 이동 설정 (초당 이동량, 기존 16ms 틱당 0.3 / 0.02 와 같은 속도)
+const float CAR_SPEED = 18.75f;
+const float CAR_ROT_SPEED = 1.25f;
+
+// 고정 시뮬레이션 주기 기본값 (Hz)
+const int DEFAULT_SIM_HZ = 60;
+
+// 이동 / 충돌 / 트랙 규칙의 버전. stepCar 나 트랙 함수의 결과가 달라지는 변경이면 올릴 것.
+// (리플레이의 build hash 에 들어가서, 규칙이 다른 빌드의 리플레이를 걸러낸다)
+// 2: 중심선을 libm sinf / cosf 대신 track_curve.h 의 다항식 sin / cos 로 계산
+const uint32_t SIMULATION_RULES_VERSION = 2;
+
+// Z 위치에 따른 도로의 중심 X 좌표를 반환 (곡선 도로 핵심 로직, 맵별 식은 track_curve.h 의 TrackCurve)
+// 한 점씩 부를 때만 사용. 여러 z 는 trackCenterXBatch 로 한 번에
+inline float getRoadCenterX(float z, int mapType) {
+    return (mapType == 1) ? TrackCurve<1>::centerX(z) : TrackCurve<2>::centerX(z);
+}
+
+// 접선 각도는 z 와 조금 앞(z - ROAD_ANGLE_DELTA)의 중심 X 차이로 계산
+const float ROAD_ANGLE_DELTA = 0.1f;
+
+inline float roadAngleFromCenters(float x1, float x2) {
+    return atan2f(x2 - x1, -ROAD_ANGLE_DELTA); // -Z 방향이 진행 방향
+}
+
+// 도로의 접선 각도 계산 (가로등 회전 등에 사용)
+inline float getRoadAngle(float z, int mapType) {
+    return roadAngleFromCenters(getRoadCenterX(z, mapType), getRoadCenterX(z - ROAD_ANGLE_DELTA, mapType));
+}
+
+// --- 트랙 샘플러 ---
+// 맵을 고를 때 중심선 X, 접선 각도, 누적 호 길이를 촘촘한 z 간격으로 미리 계산해 두고
+// 질의는 표에서 선형 보간으로 답한다. (sinf/cosf 를 매번 부르지 않음)
+// 표 범위 밖의 z 는 원래 함수로 직접 계산한다.
+const float TRACK_SAMPLE_SPACING = 0.25f;  // 샘플 간격 (z)
+const float TRACK_SAMPLE_MARGIN = 50.0f;   // 도로 앞뒤로 더 계산해 둘 거리
+
+// 위치를 중심선에 투영한 결과
+struct TrackProjection {
+    float distance;  // 출발점(z = 0)부터 중심선을 따라 잰 거리
+    float lateral;   // 중심선에서 벗어난 거리 (진행 방향 기준 오른쪽 +)
+};
+
+class TrackSampler {
+public:
+    // 맵과 도로 길이에 맞춰 표를 만든다
+    void build(int map, float length) {
+        mapType = map;
+        trackLength = length;
+        zBegin = TRACK_START_Z + TRACK_SAMPLE_MARGIN;
+        int count = (int)ceilf((zBegin + length + TRACK_SAMPLE_MARGIN) / TRACK_SAMPLE_SPACING) + 1;
+
+        centers.resize(count);
+        angles.resize(count);
+        arcs.resize(count);
+
+        // 중심 X 는 샘플 z 와 각도용 앞쪽 z 두 줄을 배치로 계산 (getRoadCenterX / getRoadAngle 과 같은 값)
+        std::vector<float> zs(count), ahead(count);
+        for (int i = 0; i < count; ++i) {
+            zs[i] = zBegin - i * TRACK_SAMPLE_SPACING;
+            ahead[i] = zs[i] - ROAD_ANGLE_DELTA;
+        }
+        trackCenterXBatch(map, zs.data(), centers.data(), count);
+        trackCenterXBatch(map, ahead.data(), ahead.data(), count);
+
+        for (int i = 0; i < count; ++i) {
+            angles[i] = roadAngleFromCenters(centers[i], ahead[i]);
+            if (i == 0) {
+                arcs[i] = 0.0f;
+                continue;
+            }
+            // 각도는 ±pi 근처에서 튀지 않도록 이어 붙임 (보간용, 회전 결과는 같음)
+            while (angles[i] - angles[i - 1] > 3.14159265f) angles[i] -= 6.28318531f;
+            while (angles[i] - angles[i - 1] < -3.14159265f) angles[i] += 6.28318531f;
+
+            float dx = centers[i] - centers[i - 1];
+            arcs[i] = arcs[i - 1] + sqrtf(dx * dx + TRACK_SAMPLE_SPACING * TRACK_SAMPLE_SPACING);
+        }
+        arcOrigin = 0.0f;
+        arcOrigin = arcLengthAt(0.0f);
+    }
+
+    // 이미 이 맵/길이 이상으로 만들어져 있는지
+    bool covers(int map, float length) const {
+        return mapType == map && !centers.empty() && trackLength >= length;
+    }
+
+    // getRoadCenterX 와 같은 값 (보간)
+    float centerX(float z) const {
+        int i; float t;
+        if (!locate(z, i, t)) return getRoadCenterX(z, mapType);
+        return centers[i] + (centers[i + 1] - centers[i]) * t;
+    }
+
+    // getRoadAngle 과 같은 값 (보간, 2pi 차이가 날 수 있음)
+    float angle(float z) const {
+        int i; float t;
+        if (!locate(z, i, t)) return getRoadAngle(z, mapType);
+        return angles[i] + (angles[i + 1] - angles[i]) * t;
+    }
+
+    // 출발점(z = 0)부터 중심선을 따라 z 까지 간 거리 (표 밖은 직선으로 연장)
+    float arcLengthAt(float z) const {
+        int i; float t;
+        if (!locate(z, i, t)) {
+            if (centers.empty()) return -z;
+            if (z > zBegin) return arcs.front() - (z - zBegin) - arcOrigin;
+            return arcs.back() + (zBegin - (centers.size() - 1) * TRACK_SAMPLE_SPACING - z) - arcOrigin;
+        }
+        return arcs[i] + (arcs[i + 1] - arcs[i]) * t - arcOrigin;
+    }
+
+    // 임의 위치 (x, z) 를 가장 가까운 중심선 점에 투영
+    TrackProjection project(float x, float z) const {
+        TrackProjection result;
+        int i; float t;
+        if (!locate(z, i, t)) {
+            result.distance = arcLengthAt(z);
+            result.lateral = x - getRoadCenterX(z, mapType);
+            return result;
+        }
+        // 가장 가까운 점은 (x, z) 에서 |x - 중심| 안쪽에 있으므로 그 z 범위의 구간만 본다
+        float offset = fabsf(x - (centers[i] + (centers[i + 1] - centers[i]) * t));
+        int window = (int)(offset / TRACK_SAMPLE_SPACING) + 1;
+        if (window > 64) window = 64;
+        int first = i - window < 0 ? 0 : i - window;
+        int last = i + window > (int)centers.size() - 2 ? (int)centers.size() - 2 : i + window;
+
+        float bestDist2 = 3.4e38f;
+        result.distance = 0.0f;
+        result.lateral = 0.0f;
+        for (int k = first; k <= last; ++k) {
+            float ax = centers[k], az = zBegin - k * TRACK_SAMPLE_SPACING;
+            float dx = centers[k + 1] - ax, dz = -TRACK_SAMPLE_SPACING;
+            float u = ((x - ax) * dx + (z - az) * dz) / (dx * dx + dz * dz);
+            if (u < 0.0f) u = 0.0f;
+            if (u > 1.0f) u = 1.0f;
+            float px = x - (ax + dx * u), pz = z - (az + dz * u);
+            float dist2 = px * px + pz * pz;
+            if (dist2 < bestDist2) {
+                bestDist2 = dist2;
+                result.distance = arcs[k] + (arcs[k + 1] - arcs[k]) * u - arcOrigin;
+                // 진행 방향 (dx, dz) 기준 오른쪽이면 +
+                result.lateral = (dx * pz - dz * px) >= 0.0f ? sqrtf(dist2) : -sqrtf(dist2);
+            }
+        }
+        return result;
+    }
+
+    float distanceAlongTrack(float x, float z) const { return project(x, z).distance; }
+
+    // 표 직접 접근 (batch_env.h 에서 여러 z 를 한 번에 보간할 때). 구간 번호 i = (표 시작 z - z) / TRACK_SAMPLE_SPACING
+    float tableBeginZ() const { return zBegin; }
+    int tableSize() const { return (int)centers.size(); }
+    const float* centerTable() const { return centers.data(); }
+    const float* angleTable() const { return angles.data(); }
+    const float* arcTable() const { return arcs.data(); }
+    float arcTableOrigin() const { return arcOrigin; }
+
+private:
+    // z 가 속한 구간 번호와 구간 안 비율
+    bool locate(float z, int& i, float& t) const {
+        if (centers.size() < 2) return false;
+        float f = (zBegin - z) / TRACK_SAMPLE_SPACING;
+        if (!(f >= 0.0f) || f >= (float)(centers.size() - 1)) return false;
+        i = (int)f;
+        t = f - i;
+        return true;
+    }
+
+    int mapType = 0;
+    float trackLength = 0.0f;
+    float zBegin = 0.0f;
+    float arcOrigin = 0.0f;
+    std::vector<float> centers;  // 중심선 X
+    std::vector<float> angles;   // 접선 각도
+    std::vector<float> arcs;     // 표 시작부터의 누적 호 길이
+};
+
+// 맵별 트랙 샘플러 (map 1, map 2 각각 하나)
+// 청크 생성 / 맵 준비 / 검증 / BatchEnv 의 작업 스레드가 참조로 읽으므로, 작업 스레드를 띄우기 전에
+// prepareTrackSamplers 로 두 맵을 한 번에 만들어 두고 그 뒤로는 읽기만 한다. (resetCar 도 만들지 않음)
+inline TrackSampler& trackSamplerSlot(int mapType) {
+    static TrackSampler samplers[2];
+    return samplers[mapType == 1 ? 0 : 1];
+}
+
+inline const TrackSampler& getTrackSampler(int mapType) {
+    return trackSamplerSlot(mapType);
+}
+
+// 이 맵의 표가 trackLength 까지 만들어져 있는지
+inline bool trackSamplerReady(int mapType, float trackLength) {
+    return getTrackSampler(mapType).covers(mapType, trackLength);
+}
+
+// 시작할 때 (표를 읽는 스레드가 없을 때) 호출: 두 맵의 표가 없거나 짧으면 새로 만든다.
+// 이미 덮고 있으면 아무것도 하지 않으므로 같은 길이로 여러 번 불러도 된다.
+inline void prepareTrackSamplers(float trackLength) {
+    static std::mutex buildMutex;
+    std::lock_guard<std::mutex> lock(buildMutex);
+    for (int map = 1; map <= 2; ++map) {
+        TrackSampler& sampler = trackSamplerSlot(map);
+        if (!sampler.covers(map, trackLength)) sampler.build(map, trackLength);
+    }
+}
+
+// 한 틱 동안의 방향키 입력
+struct CarInput {
+    bool up = false;
+    bool down = false;
+    bool left = false;
+    bool right = false;
+
+    bool any() const { return up || down || left || right; }
+};
+
+// 한 틱 진행 후의 결과
+enum StepResult { STEP_RUNNING, STEP_FINISHED, STEP_CRASHED };
+
+// 자동차 + 레이스 타이머 상태
+struct CarState {
+    int mapType = 1;
+    float finishZ = FINISH_LINE_Z;
+    float x = 0.0f;
+    float z = 0.0f;
+    float angle = 0.0f;
+
+    long long tick = 0;          // 진행한 틱 수
+    bool timerStarted = false;
+    long long startTick = 0;
+    int elapsedTime = 0;         // ms
+    bool finishReached = false;
+};
+
+// 맵 시작 위치로 초기화 (표는 prepareTrackSamplers 로 미리 만들어 둘 것)
+inline void resetCar(CarState& s, int mapType, float trackLength = DEFAULT_TRACK_LENGTH) {
+    assert(trackSamplerReady(mapType, trackLength));
+    s = CarState();
+    s.mapType = mapType;
+    s.finishZ = getFinishLineZ(trackLength);
+    s.x = getTrackSampler(mapType).centerX(0.0f); // 도로 중앙에서 시작
+}
+
+// 틱 수 -> 레이스 시간(ms). 기록은 벽시계가 아니라 틱 수로 계산하므로 기기 부하와 무관하다.
+inline int ticksToMs(long long ticks, float dt) {
+    return (int)(ticks * (double)dt * 1000.0 + 0.5);
+}
+
+// 입력을 받아 고정 시간 dt(초) 만큼 한 틱 진행
+inline StepResult stepCar(CarState& s, const CarInput& in, float dt) {
+    float forwardX = sinf(s.angle);
+    float forwardZ = -cosf(s.angle);
+    float move = CAR_SPEED * dt;
+    float turn = CAR_ROT_SPEED * dt;
+
+    // 방향키가 입력되면 타이머 시작
+    if (!s.timerStarted && in.any()) {
+        s.timerStarted = true;
+        s.startTick = s.tick;
+    }
+
+    if (in.up) {
+        s.x += move * forwardX;
+        s.z += move * forwardZ;
+    }
+    if (in.down) {
+        s.x -= move * forwardX;
+        s.z -= move * forwardZ;
+    }
+    if (in.left) {
+        s.angle -= turn;
+    }
+    if (in.right) {
+        s.angle += turn;
+    }
+
+    // 타이머가 시작되었고 아직 피니시라인에 도달하지 않았다면 시간 업데이트
+    if (s.timerStarted && !s.finishReached) {
+        s.elapsedTime = ticksToMs(s.tick - s.startTick, dt);
+    }
+    s.tick++;
+
+    StepResult result = STEP_RUNNING;
+
+    // 피니시라인 도달 체크
+    if (!s.finishReached && s.z <= s.finishZ) {
+        s.finishReached = true;
+        result = STEP_FINISHED;
+    }
+
+    // --- 충돌 체크 (Collision Detection) ---
+    float roadCenter = getTrackSampler(s.mapType).centerX(s.z);
+    float limit = (ROAD_WIDTH / 2.0f) - CAR_COLLISION_RADIUS;
+
+    // 도로 중심과의 거리 계산
+    if (fabsf(s.x - roadCenter) > limit) {
+        // 도로를 벗어남 -> 인도 충돌
+        result = STEP_CRASHED;
+    }
+    return result;
+}
+
+// --- 자동 운전 ---
+// 중심선의 조금 앞 지점을 향해 방향키를 누른다. (녹화된 스크립트가 없는 합성 트랙 벤치마크용)
+// 방향 오차가 크면 전진을 멈추고 회전만 해서 급커브(map 2)에서도 벗어나지 않는다.
+const float AUTOPILOT_LOOKAHEAD = 3.0f;          // 목표 지점까지 z 거리
+const float AUTOPILOT_THROTTLE_TOLERANCE = 0.1f; // 이보다 오차가 작을 때만 전진 (rad)
+const float AUTOPILOT_STEER_DEADZONE = 0.02f;    // 이보다 작은 오차는 무시 (rad)
+
+inline CarInput autopilotInput(const CarState& s) {
+    float targetZ = s.z - AUTOPILOT_LOOKAHEAD;
+    float targetX = getTrackSampler(s.mapType).centerX(targetZ);
+    float error = atan2f(targetX - s.x, AUTOPILOT_LOOKAHEAD) - s.angle;
+
+    CarInput in;
+    in.up = fabsf(error) < AUTOPILOT_THROTTLE_TOLERANCE;
+    if (error > AUTOPILOT_STEER_DEADZONE) in.right = true;
+    else if (error < -AUTOPILOT_STEER_DEADZONE) in.left = true;
+    return in;
+}
+
+// 출발점에서 피니시라인까지 중심선 기준 진행률 (0 ~ 1, 뒤로 가면 음수)
+inline float trackProgress(const CarState& s) {
+    const TrackSampler& track = getTrackSampler(s.mapType);
+    float total = track.arcLengthAt(s.finishZ);
+    if (total <= 0.0f) return 0.0f;
+    return track.distanceAlongTrack(s.x, s.z) / total;
+}
+
+// 렌더링용 보간: 직전 틱(prev)과 현재 틱(curr) 사이 alpha(0~1) 지점의 자세
+inline CarState lerpCar(const CarState& prev, const CarState& curr, float alpha) {
+    CarState out = curr;
+    out.x = prev.x + (curr.x - prev.x) * alpha;
+    out.z = prev.z + (curr.z - prev.z) * alpha;
+    out.angle = prev.angle + (curr.angle - prev.angle) * alpha;
+    return out;
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+// --- 단일 생산자 / 단일 소비자 큐 ---
+// 고정 크기 링 버퍼. 생산자 스레드 하나가 tryPush, 소비자 스레드 하나가 tryPop 만 호출한다.
+// 락 없이 원자 변수 두 개(head, tail)로 동기화하며, 가득 차면 기다리지 않고 false 를 돌려준다.
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 생산자 스레드 전용
+    bool tryPush(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= Capacity) return false; // 가득 참
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 소비자 스레드 전용
+    bool tryPop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false; // 비어 있음
+        out = std::move(slots[h & (Capacity - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // 생산자와 소비자가 같은 캐시 라인을 두고 다투지 않도록 떨어뜨려 둔다
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    T slots[Capacity];
+};
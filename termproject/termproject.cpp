@@ -1,19 +1,39 @@
 ﻿#define _CRT_SECURE_NO_WARNINGS
-#include <gl/glew.h>
-#include <gl/freeglut.h>
-#include <gl/freeglut_ext.h>
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include <GL/freeglut_ext.h>
 #include <iostream>
 #include <vector>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <assert.h>
 #include <string>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <memory>
+#include <stddef.h>
+#include <mutex>
+#include <deque>
+#include <functional>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include "font_helvetica18.h"
+#include "mesh_builder.h"
+#include "profiler.h"
+#include "leaderboard.h"
+#include "replay.h"
+#include "ghost.h"
+#include "batch_env.h"
+#include "mathlib.h"
+#include "program_cache.h"
+#include "headless_gl.h"
 
 // --- 파일 읽기 ---
 char* filetobuf(const char* file) {
@@ -30,217 +50,232 @@ char* filetobuf(const char* file) {
 }
 
 // --- 게임 상태 및 전역 변수 ---
-enum GameState { MENU, PLAY, GAMEOVER, RANKING, NAME_INPUT };
+enum GameState { MENU, PLAY, GAMEOVER, RANKING, NAME_INPUT, LOADING };
+const char* GAME_STATE_NAMES[] = { "Menu", "Play", "GameOver", "Ranking", "NameInput", "Loading" };
 GameState currentState = MENU;
 int selectedMap = 1; // 1 or 2
 
-// 랭킹 구조체
-struct RankingEntry {
-    int mapType;
-    float time;
-    std::string name;
-
-    bool operator<(const RankingEntry& other) const {
-        return time < other.time;
-    }
+// 랭킹 (rankings.log / rankings.snapshot / rankings.board, leaderboard.h 참고)
+Leaderboard leaderboard;
+const int RANKING_SHOWN = 5; // 랭킹 화면에 보여줄 맵별 순위 수
+
+// 리플레이 (replay.h). 매 레이스 입력을 녹화해 replays/last.rpl 에 남기고, 랭킹에 오르면 replays/<seq>.rpl 로도 저장.
+const char* LAST_REPLAY_FILE = "replays/last.rpl";
+const int REPLAY_FAST_FORWARD = 8;   // 재생 중 'F' 빨리 감기 배속
+Replay raceRecording;                // 지금 레이스의 입력
+Replay playbackReplay;               // --replay 로 불러온 리플레이
+ReplayCursor playbackCursor;
+bool playbackPending = false;        // 리플레이 맵이 올라가면 재생 시작
+bool playbackActive = false;         // 이번 레이스는 키 대신 리플레이 입력으로 진행
+bool playbackFastForward = false;
+
+// 고스트 (ghost.h). 레이스를 시작하면 이 맵의 1위 / 5위 / 개인 최고 기록 리플레이가 반투명 자동차로 같이 달린다.
+enum GhostKind { GHOST_TOP1, GHOST_TOP5, GHOST_PERSONAL_BEST, MAX_GHOSTS };
+const int GHOST_TOP_RANK = 5;
+const char* GHOST_LABELS[MAX_GHOSTS] = { "1st", "5th", "PB" };
+const float GHOST_TINTS[MAX_GHOSTS][4] = {   // rgb 는 자동차 색에 곱함, a 는 투명도
+    { 1.0f, 0.85f, 0.3f, 0.45f },
+    { 0.5f, 0.7f, 1.0f, 0.45f },
+    { 0.5f, 1.0f, 0.5f, 0.45f },
 };
-
-std::vector<RankingEntry> rankingsMap1;
-std::vector<RankingEntry> rankingsMap2;
+GhostStream ghosts[MAX_GHOSTS];
+bool ghostsEnabled = true;
+std::string ghostPlayerName;         // 개인 최고 기록을 찾을 이름 (이번 실행에서 마지막으로 저장한 이름)
 
 // 이름 입력 관련
 std::string currentInputName = "";
 float recordedTime = 0.0f;
 
 GLuint shaderProgramID;
-GLuint vertexShader, fragmentShader;
-GLuint bgVAO, bgVBO;
-GLuint carVAO, carVBO;
-GLuint lightVAO, lightVBO;
-GLuint finishLineVAO, finishLineVBO;
+GLuint textProgramID;
+GLuint bgVAO, bgVBO, bgEBO;
+GLuint carVAO, carVBO, carEBO;
+GLuint ghostInstanceVBO; // 고스트 인스턴스 (모델 행렬 + 색), carVAO 의 location 4~8
+GLuint lightVAO, lightVBO, lightEBO;
+GLuint finishLineVAO, finishLineVBO, finishLineEBO;
+int carIndexCount = 0;
+int drawCallCount = 0; // 이번 프레임의 draw call 수 (벤치마크 보고용)
+int finishLineIndexCount = 0;
+GLuint lampInstanceVBO; // 가로등 인스턴스 행렬 (청크 링 슬롯마다 LAMPS_PER_CHUNK 개)
 
 GLuint roadTextureID, dirtTextureID;
 
-GLuint modelLoc, viewLoc, projLoc;
-GLuint useTextureLoc, isLightSourceLoc, viewPosLoc;
+GLuint modelLoc;
+GLuint normalMatrixLoc;
+GLuint useTextureLoc, isLightSourceLoc;
+GLuint useInstancingLoc;
+
+// 씬 유니폼 블록 (shader 의 SceneBlock 과 std140 레이아웃이 같아야 함)
+const GLuint SCENE_BLOCK_BINDING = 0;
+
+struct SceneUniforms {
+    Mat4 view;
+    Mat4 projection;
+    float viewPos[4];
+    float clusterParams[4]; // x,y: 타일 크기(px), z,w: 깊이 slice scale, bias
+    int clusterDims[4];     // x,y,z: 클러스터 개수
+};
 
-// 자동차 상태
-float carX = 0.0f;
-float carZ = 0.0f;
-float carAngle = 0.0f;
+SceneUniforms sceneUniforms;
+GLuint sceneUBO;
 
-// 타이머 관련
-bool timerStarted = false;
-int startTime = 0;
-int elapsedTime = 0;
-bool finishReached = false;
+// 자동차 + 타이머 상태 (시뮬레이션 코어)
+CarState car;
+CarState prevCar; // 직전 틱 상태 (렌더링 보간용)
 
 // 도로 설정
-const float ROAD_WIDTH = 2.0f;       // 도로 전체 폭
-const float SIDEWALK_WIDTH = 1.5f;   // 인도 폭
-const float CAR_COLLISION_RADIUS = 0.5f; // 자동차 충돌 반경
 const float TRACK_RADIUS = 80.0f; // 트랙의 반지름 (크기)
 const int TRACK_SEGMENTS = 360;   // 원을 몇 개로 쪼갤지
-int vertexCountRoad = 0;
-int vertexCountSidewalk = 0;
-const float FINISH_LINE_Z = -495.0f; // 피니시라인 위치
+float trackLength = DEFAULT_TRACK_LENGTH; // 도로 길이 (--track-length)
+
+// 가로등 배치
+const float LAMP_SPACING = 20.0f;
+const int LAMP_POLE_INDEX_COUNT = 72; // 기둥 + 팔
+const int LAMP_BULB_INDEX_COUNT = 36; // 전구
 
 // 키 상태 추적
 bool specialKeyStates[256] = { false };
 
-// --- 수학 헬퍼 함수 ---
-// Z 위치에 따른 도로의 중심 X 좌표를 반환 (곡선 도로 핵심 로직)
-float getRoadCenterX(float z, int mapType) {
-    if (mapType == 1) {
-        // Map 1: 완만한 Sine 파형
-        return sinf(z * 0.05f) * 10.0f;
-    }
-    else {
-        // Map 2: 더 복잡하고 급격한 곡선
-        return sinf(z * 0.1f) * 10.0f + cosf(z * 0.05f) * 5.0f;
-    }
-}
+// 창 크기 (클러스터 타일 크기 계산용)
+int winWidth = 800;
+int winHeight = 600;
+
+// 카메라 투영 설정
+const float CAMERA_FOV = 3.141592f / 4.0f;
+const float CAMERA_ASPECT = 800.0f / 600.0f;
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 300.0f;
+
+// --- 클러스터 조명 (Clustered Forward Lighting) 설정 ---
+// 화면을 CLUSTER_X x CLUSTER_Y 타일, 깊이를 CLUSTER_Z 개의 지수 간격 slice 로 나누고
+// 매 프레임 CPU 에서 각 클러스터에 닿는 가로등 목록을 만든다.
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+const int CLUSTER_TILES = CLUSTER_X * CLUSTER_Y;
+const int CLUSTER_COUNT = CLUSTER_TILES * CLUSTER_Z;
+const int MAX_LIGHTS_PER_CLUSTER = 64;
+const float LAMP_LIGHT_RADIUS = 30.0f; // 가로등 빛이 닿는 최대 거리
+
+// 가로등 조명 (월드 좌표, radius 0 은 빈 자리)
+struct LampLight {
+    float x, y, z;
+    float radius;
+};
+std::vector<LampLight> lampLights;
 
-// 도로의 접선 각도 계산 (가로등 회전 등에 사용)
-float getRoadAngle(float z, int mapType) {
-    float delta = 0.1f;
-    float x1 = getRoadCenterX(z, mapType);
-    float x2 = getRoadCenterX(z - delta, mapType);
-    return atan2f(x2 - x1, -delta); // -Z 방향이 진행 방향
-}
+GLuint lightDataTBO, lightDataTex;      // 가로등 데이터 (청크가 올라올 때 해당 슬롯만 갱신)
+GLuint clusterTBO, clusterTex;          // 클러스터별 (시작 위치, 개수)
+GLuint lightIndexTBO, lightIndexTex;    // 클러스터별 조명 인덱스 목록
 
-void setIdentityMatrix(float* mat, int size) {
-    for (int i = 0; i < size * size; ++i) mat[i] = 0.0f;
-    for (int i = 0; i < size; ++i) mat[i * size + i] = 1.0f;
-}
-void makePerspectiveMatrix(float* mat, float fov, float aspect, float nearDist, float farDist) {
-    setIdentityMatrix(mat, 4);
-    float tanHalfFov = tanf(fov / 2.0f);
-    mat[0] = 1.0f / (aspect * tanHalfFov);
-    mat[5] = 1.0f / tanHalfFov;
-    mat[10] = -(farDist + nearDist) / (farDist - nearDist);
-    mat[11] = -1.0f;
-    mat[14] = -(2.0f * farDist * nearDist) / (farDist - nearDist);
-    mat[15] = 0.0f;
-}
-void setTranslationMatrix(float* mat, float x, float y, float z) {
-    setIdentityMatrix(mat, 4);
-    mat[12] = x; mat[13] = y; mat[14] = z;
-}
-void setRotationYMatrix(float* mat, float angle) {
-    setIdentityMatrix(mat, 4);
-    float c = cosf(angle);
-    float s = sinf(angle);
-    mat[0] = c;  mat[2] = s;
-    mat[8] = -s; mat[10] = c;
-}
+// 카메라 공간으로 옮긴 가로등 (이번 프레임에 보이는 것만)
+struct ViewLight {
+    float x, y, depth, radius;
+    unsigned int index;
+};
+std::vector<ViewLight> visibleLights;
 
-// --- 랭킹 관련 함수 ---
-void loadRankings() {
-    rankingsMap1.clear();
-    rankingsMap2.clear();
-
-    std::ifstream file("rankings.txt");
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            std::istringstream iss(line);
-            int mapType;
-            float time;
-            std::string name;
-
-            if (iss >> mapType >> time) {
-                // 나머지 부분을 이름으로 읽기
-                std::getline(iss, name);
-                // 앞의 공백 제거
-                if (!name.empty() && name[0] == ' ') {
-                    name = name.substr(1);
-                }
+// slice 마다 독립된 작업 공간 (스레드끼리 겹치지 않음)
+struct ClusterSlice {
+    int counts[CLUSTER_TILES];
+    unsigned int lights[CLUSTER_TILES][MAX_LIGHTS_PER_CLUSTER];
+};
+std::vector<ClusterSlice> clusterSlices(CLUSTER_Z);
+std::vector<unsigned int> clusterTable(CLUSTER_COUNT * 2);
+std::vector<unsigned int> clusterLightIndices;
+
+ThreadPool* workerPool = NULL;
+
+// --- 도로 스트리밍 설정 ---
+// 도로를 CHUNK_LENGTH 길이의 청크로 나눠 자동차 주변 것만 만들고, 고정 크기 GPU 링 버퍼 슬롯에 올린다.
+// 뒤로 지나간 청크는 슬롯을 비워 앞쪽 청크에 재사용하므로 트랙 길이와 상관없이 메모리/그리기 양이 같다.
+const float ROAD_STEP = 2.0f;                                  // 도로 한 구간 길이
+const float CHUNK_LENGTH = 40.0f;                              // 청크 하나의 z 길이
+const int SEGMENTS_PER_CHUNK = (int)(CHUNK_LENGTH / ROAD_STEP);
+const int CHUNK_MAX_INDICES = SEGMENTS_PER_CHUNK * (6 + 24);   // 도로 6 + 인도/연석 24 인덱스 / 구간
+const int CHUNK_MAX_VERTICES = CHUNK_MAX_INDICES;               // 정점 중복 제거 전 최대치 (슬롯 크기)
+const int LAMPS_PER_CHUNK = (int)(CHUNK_LENGTH / LAMP_SPACING);
+const int CHUNKS_BEHIND = 1;                                   // 자동차 뒤로 남겨둘 청크 수
+const int CHUNKS_AHEAD = 10;                                   // 미리 만들어 둘 앞쪽 청크 수 (시야 300 + 여유)
+const int CHUNK_RING_SIZE = CHUNKS_BEHIND + 1 + CHUNKS_AHEAD;
+const int LAMP_INSTANCE_COUNT = CHUNK_RING_SIZE * LAMPS_PER_CHUNK;
+
+// 작업 스레드가 만든 청크 하나
+struct RoadChunk {
+    int mapType;
+    int index;
+    int generation;                 // 맵을 다시 고르면 증가 (이전 맵 결과 폐기용)
+    MeshBuilder mesh;               // 도로 인덱스 뒤에 인도/연석 인덱스
+    int roadIndexCount;
+    int sidewalkIndexCount;
+    int lampCount;
+    Mat4 lampModels[LAMPS_PER_CHUNK];
+    LampLight lights[LAMPS_PER_CHUNK];
+};
 
-                RankingEntry entry;
-                entry.mapType = mapType;
-                entry.time = time;
-                entry.name = name.empty() ? "Anonymous" : name;
+// GPU 링 버퍼의 슬롯 하나
+struct ChunkSlot {
+    int chunkIndex = -1;            // -1 이면 비어 있음
+    int roadIndexCount = 0;
+    int sidewalkIndexCount = 0;
+};
 
-                if (mapType == 1) {
-                    rankingsMap1.push_back(entry);
-                }
-                else if (mapType == 2) {
-                    rankingsMap2.push_back(entry);
-                }
-            }
-        }
-        file.close();
-    }
+ChunkSlot chunkSlots[CHUNK_RING_SIZE];
+int streamGeneration = 0;
+std::vector<int> pendingChunks;                         // 요청했지만 아직 안 돌아온 청크
+std::mutex readyChunksMutex;
+std::vector<std::unique_ptr<RoadChunk>> readyChunks;    // 작업 스레드 -> 렌더 스레드
+
+// 게임 루프 설정
+int simHz = DEFAULT_SIM_HZ;      // 고정 시뮬레이션 주기 (--sim-hz)
+int renderIntervalMs = 16;       // 렌더링 타이머 간격 (--fps)
+const int MAX_SUBSTEPS = 8;      // 한 프레임에 따라잡을 최대 틱 수 (부하가 심하면 나머지는 버림)
+float simAccumulator = 0.0f;     // 아직 시뮬레이션하지 않은 시간 (ms)
+int lastFrameTime = 0;
+float renderAlpha = 1.0f;        // 직전 틱 -> 현재 틱 보간 비율
+// PLAY 가 아닌 화면은 정지 화면이라 입력이나 상태가 바뀔 때만 다시 그린다.
+// 그동안은 타이머도 멈춰 두고, PLAY 로 들어가면 다시 건다.
+bool redrawPending = false;      // 다시 그리기 요청됨 (drawScene 이 지움)
+bool timerRunning = false;
+bool headlessContext = false;    // GLUT 창 없이 EGL 컨텍스트로 실행 중 (리눅스 벤치마크, FBO 에만 그림)
 
-    std::sort(rankingsMap1.begin(), rankingsMap1.end());
-    std::sort(rankingsMap2.begin(), rankingsMap2.end());
+// --- 랭킹 관련 함수 ---
+// 종료 시: 쓰기 대기 중인 기록을 모두 디스크에 씀 (exit() 로 끝나도 atexit 으로 호출됨)
+void flushRankings() {
+    leaderboard.close();
 }
 
-void saveRanking(int mapType, float time, const std::string& name) {
-    RankingEntry newEntry;
-    newEntry.mapType = mapType;
-    newEntry.time = time;
-    newEntry.name = name.empty() ? "Anonymous" : name;
-
-    if (mapType == 1) {
-        rankingsMap1.push_back(newEntry);
-        std::sort(rankingsMap1.begin(), rankingsMap1.end());
-        if (rankingsMap1.size() > 5) {
-            rankingsMap1.resize(5);
-        }
-    }
-    else if (mapType == 2) {
-        rankingsMap2.push_back(newEntry);
-        std::sort(rankingsMap2.begin(), rankingsMap2.end());
-        if (rankingsMap2.size() > 5) {
-            rankingsMap2.resize(5);
-        }
-    }
+// 시작 시 한 번: board 를 매핑하고 그 뒤 저널 기록만 읽는다
+void loadRankings() {
+    leaderboard.open();
+    atexit(flushRankings);
+}
 
-    // 파일에 저장
-    std::ofstream file("rankings.txt");
-    if (file.is_open()) {
-        for (const auto& entry : rankingsMap1) {
-            file << entry.mapType << " " << entry.time << " " << entry.name << "\n";
-        }
-        for (const auto& entry : rankingsMap2) {
-            file << entry.mapType << " " << entry.time << " " << entry.name << "\n";
-        }
-        file.close();
+// 완주 기록 추가 (메모리 색인은 바로, 파일 쓰기는 백그라운드 스레드에서)
+// 이번 레이스의 리플레이도 기록 seq 이름으로 저장 (고스트 / 검증용)
+void saveRanking(int mapType, float time, const std::string& name) {
+    uint64_t seq = leaderboard.add(mapType, time, name);
+    if (!name.empty()) ghostPlayerName = name;
+    if (!raceRecording.save(replayPathForSeq(seq))) {
+        std::cerr << "Failed to save replay" << std::endl;
     }
 }
 
-// 텍스트 출력 함수
-void drawString(const char* str, int x, int y) {
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
-    glUseProgram(0); // 고정 파이프라인 사용
-
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, 800, 0, 600);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glRasterPos2i(x, y);
-    for (int i = 0; str[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, str[i]);
-    }
+// --- 텍스처 로드 ---
+// 디코딩(작업 스레드 가능)과 GL 업로드(GL 스레드)를 나눠 둔다. 에셋 로딩 참고.
+struct DecodedImage {
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = NULL;
+    ~DecodedImage() { stbi_image_free(pixels); }
+};
 
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glEnable(GL_DEPTH_TEST);
+// 세로 뒤집기 설정은 startAssetLoading() 에서 한 번만 함 (stb 전역 설정)
+bool decodeImage(const char* filename, DecodedImage& out) {
+    out.pixels = stbi_load(filename, &out.width, &out.height, &out.channels, 0);
+    return out.pixels != NULL;
 }
 
-// --- 텍스처 로드 ---
-GLuint LoadTexture(const char* filename) {
+GLuint uploadTexture(const DecodedImage& image, const char* filename) {
     GLuint textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
@@ -249,146 +284,728 @@ GLuint LoadTexture(const char* filename) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filename, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    if (image.pixels) {
+        GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
         glGenerateMipmap(GL_TEXTURE_2D);
     }
     else {
         std::cout << "Texture Load Failed (Use Default Color): " << filename << std::endl;
     }
-    stbi_image_free(data);
     return textureID;
 }
 
 // --- 쉐이더 컴파일 ---
-void make_Shaders() {
-    GLchar* vSrc = filetobuf("vertex.glsl");
-    GLchar* fSrc = filetobuf("fragment.glsl");
-    if (!vSrc || !fSrc) { std::cerr << "Shader file not found!" << std::endl; exit(1); }
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+// 링크된 프로그램은 program_cache.h 로 저장해 두고 다음 실행부터는 바이너리를 바로 불러온다.
+ProgramCache programCache;
+
+// 컴파일 / 링크 실패 시 로그를 출력하고 false
+bool checkShader(GLuint shader, const char* name) {
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (ok) return true;
+    char log[1024];
+    glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+    std::cerr << "Shader compile failed (" << name << "):\n" << log << std::endl;
+    return false;
+}
+
+bool checkProgram(GLuint program, const char* name) {
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (ok) return true;
+    char log[1024];
+    glGetProgramInfoLog(program, sizeof(log), NULL, log);
+    std::cerr << "Program link failed (" << name << "):\n" << log << std::endl;
+    return false;
+}
+
+// 소스에서 컴파일 (실패하면 0)
+GLuint compileProgram(const char* name, const GLchar* vSrc, const GLchar* fSrc) {
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(vertexShader, 1, &vSrc, NULL);
     glShaderSource(fragmentShader, 1, &fSrc, NULL);
     glCompileShader(vertexShader);
     glCompileShader(fragmentShader);
-    shaderProgramID = glCreateProgram();
-    glAttachShader(shaderProgramID, vertexShader);
-    glAttachShader(shaderProgramID, fragmentShader);
-    glLinkProgram(shaderProgramID);
+    bool compiled = checkShader(vertexShader, name);
+    compiled = checkShader(fragmentShader, name) && compiled;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    if (programCache.supported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    if (!compiled || !checkProgram(program, name)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// 캐시된 바이너리가 있으면 그것을, 없거나 거부되면 컴파일 후 캐시에 저장
+GLuint buildProgram(const char* name, const std::string& vSrc, const std::string& fSrc) {
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t key = programCache.key(vSrc, fSrc);
+    GLuint program = programCache.tryLoad(key);
+    bool cached = program != 0;
+    if (!cached) {
+        program = compileProgram(name, vSrc.c_str(), fSrc.c_str());
+        if (!program) exit(1);
+        programCache.store(key, program);
+    }
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    printf("Shader %s: %s (%.1f ms)\n", name, cached ? "cached binary" : "compiled", ms);
+    return program;
+}
+
+GLuint make_Program(const char* vsFile, const char* fsFile) {
+    GLchar* vSrc = filetobuf(vsFile);
+    GLchar* fSrc = filetobuf(fsFile);
+    if (!vSrc || !fSrc) { std::cerr << "Shader file not found!" << std::endl; exit(1); }
+    GLuint program = buildProgram(vsFile, vSrc, fSrc);
     free(vSrc); free(fSrc);
+    return program;
 }
 
-// --- 맵 생성 ---
-void initMapBuffer(int mapType) {
-    std::vector<float> v;
-    float step = 2.0f;
-    float startZ = 20.0f;
+// --- 텍스트 렌더러 ---
+// 한 프레임의 모든 HUD/메뉴 문자열을 정점 버퍼 하나에 모았다가 flushText() 에서 한 번에 그린다.
+// 글리프는 시작할 때 font_helvetica18.h 데이터로 만든 아틀라스 텍스처에서 가져온다.
+const float TEXT_SCREEN_W = 800.0f; // 텍스트 좌표계 (기존 gluOrtho2D(0, 800, 0, 600) 과 동일)
+const float TEXT_SCREEN_H = 600.0f;
+const int GLYPH_ATLAS_WIDTH = 256;
+
+struct TextVertex {
+    float x, y;
+    float u, v;
+    unsigned char r, g, b, a;
+};
+
+struct GlyphInfo {
+    float u0, v0, u1, v1;
+    int width;
+};
+
+GlyphInfo glyphs[FONT_GLYPH_COUNT];
+std::vector<TextVertex> textVertices;
+GLuint textVAO, textVBO, glyphAtlasTex;
+GLint textScreenSizeLoc;
+
+// 글리프 비트맵을 한 줄씩 채워 넣는 아틀라스 생성 + 텍스트용 VAO 준비
+void initTextRenderer() {
+    // 1) 배치 계산 (글리프 사이 1px 여백)
+    int penX = 1, penY = 1;
+    int placeX[FONT_GLYPH_COUNT], placeY[FONT_GLYPH_COUNT];
+    for (int i = 0; i < FONT_GLYPH_COUNT; ++i) {
+        int w = FONT_GLYPH_WIDTH[i];
+        if (penX + w + 1 > GLYPH_ATLAS_WIDTH) {
+            penX = 1;
+            penY += FONT_HEIGHT + 1;
+        }
+        placeX[i] = penX;
+        placeY[i] = penY;
+        penX += w + 1;
+    }
+    int atlasHeight = penY + FONT_HEIGHT + 1;
+
+    // 2) 1비트 글리프를 8비트 텍스처로 펼치기
+    std::vector<unsigned char> pixels(GLYPH_ATLAS_WIDTH * atlasHeight, 0);
+    for (int i = 0; i < FONT_GLYPH_COUNT; ++i) {
+        int w = FONT_GLYPH_WIDTH[i];
+        int bytesPerRow = (w + 7) / 8;
+        const unsigned char* bits = FONT_GLYPH_BITS + FONT_GLYPH_OFFSET[i];
+        for (int row = 0; row < FONT_HEIGHT; ++row) {
+            for (int col = 0; col < w; ++col) {
+                if (bits[row * bytesPerRow + col / 8] & (0x80 >> (col % 8))) {
+                    pixels[(placeY[i] + row) * GLYPH_ATLAS_WIDTH + placeX[i] + col] = 255;
+                }
+            }
+        }
+        glyphs[i].u0 = (float)placeX[i] / GLYPH_ATLAS_WIDTH;
+        glyphs[i].v0 = (float)placeY[i] / atlasHeight;
+        glyphs[i].u1 = (float)(placeX[i] + w) / GLYPH_ATLAS_WIDTH;
+        glyphs[i].v1 = (float)(placeY[i] + FONT_HEIGHT) / atlasHeight;
+        glyphs[i].width = w;
+    }
+
+    glGenTextures(1, &glyphAtlasTex);
+    glBindTexture(GL_TEXTURE_2D, glyphAtlasTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GLYPH_ATLAS_WIDTH, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // 3) 매 프레임 다시 채우는 동적 정점 버퍼
+    glGenVertexArrays(1, &textVAO);
+    glGenBuffers(1, &textVBO);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    int stride = sizeof(TextVertex);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)0); glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(2 * sizeof(float))); glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(4 * sizeof(float))); glEnableVertexAttribArray(2);
+
+    glUseProgram(textProgramID);
+    glUniform1i(glGetUniformLocation(textProgramID, "glyphAtlas"), 0);
+    textScreenSizeLoc = glGetUniformLocation(textProgramID, "screenSize");
+    glUniform2f(textScreenSizeLoc, TEXT_SCREEN_W, TEXT_SCREEN_H);
+}
+
+// 텍스트 출력 함수 - (x, y) 는 800x600 좌표계의 첫 글자 기준선 위치. 실제 그리기는 flushText() 에서.
+void drawString(const char* str, int x, int y) {
+    float penX = (float)x;
+    float y0 = (float)(y - FONT_DESCENT);
+    float y1 = y0 + FONT_HEIGHT;
+    for (int i = 0; str[i] != '\0'; i++) {
+        int c = (unsigned char)str[i];
+        if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) continue;
+        const GlyphInfo& g = glyphs[c - FONT_FIRST_CHAR];
+        float x0 = penX, x1 = penX + g.width;
+
+        TextVertex quad[6] = {
+            { x0, y0, g.u0, g.v0, 255, 255, 255, 255 },
+            { x1, y0, g.u1, g.v0, 255, 255, 255, 255 },
+            { x1, y1, g.u1, g.v1, 255, 255, 255, 255 },
+            { x0, y0, g.u0, g.v0, 255, 255, 255, 255 },
+            { x1, y1, g.u1, g.v1, 255, 255, 255, 255 },
+            { x0, y1, g.u0, g.v1, 255, 255, 255, 255 },
+        };
+        textVertices.insert(textVertices.end(), quad, quad + 6);
+        penX += g.width;
+    }
+}
 
-    // 도로 길이 -500으로 변경
-    float endZ = -500.0f;
+// 이번 프레임에 모은 문자열을 한 번의 draw call 로 그림
+void flushText() {
+    if (textVertices.empty()) return;
+    PROFILE_SCOPE("Text");
+    PROFILE_GPU_SCOPE("Text");
+
+    glUseProgram(textProgramID);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, glyphAtlasTex);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    glBufferData(GL_ARRAY_BUFFER, textVertices.size() * sizeof(TextVertex), textVertices.data(), GL_STREAM_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)textVertices.size());
+    drawCallCount++;
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    textVertices.clear();
+}
+
+// 씬 유니폼 블록 버퍼 생성 및 바인딩 포인트 연결 (시작 시 한 번)
+void initSceneUniformBlock() {
+    GLuint blockIndex = glGetUniformBlockIndex(shaderProgramID, "SceneBlock");
+    glUniformBlockBinding(shaderProgramID, blockIndex, SCENE_BLOCK_BINDING);
+
+    memset(&sceneUniforms, 0, sizeof(sceneUniforms));
+    glGenBuffers(1, &sceneUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_BLOCK_BINDING, sceneUBO);
+}
+
+// --- 메시 업로드 ---
+// 압축 정점 레이아웃 (mesh_builder.h 의 PackedVertex) 을 현재 VAO 에 연결
+void setupPackedVertexAttribs() {
+    int stride = sizeof(PackedVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, pos)); glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, color)); glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, uv)); glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal)); glEnableVertexAttribArray(3);
+}
+
+// MeshBuilder 결과를 VAO / 정점 버퍼 / 인덱스 버퍼에 올림 (없으면 생성)
+void uploadMesh(const MeshBuilder& mesh, GLuint* vao, GLuint* vbo, GLuint* ebo) {
+    if (*vao == 0) glGenVertexArrays(1, vao);
+    if (*vbo == 0) glGenBuffers(1, vbo);
+    if (*ebo == 0) glGenBuffers(1, ebo);
+
+    glBindVertexArray(*vao);
+    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(PackedVertex), mesh.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint16_t), mesh.indices.data(), GL_STATIC_DRAW);
+    setupPackedVertexAttribs();
+}
+
+// --- 맵 생성 ---
+// 청크 하나(z 범위 CHUNK_LENGTH)의 도로/인도/연석 정점과 가로등을 만든다. GL 호출 없음 (작업 스레드에서 실행)
+void generateRoadChunk(int mapType, int chunkIndex, float trackLength, RoadChunk& out) {
+    PROFILE_SCOPE("GenerateChunk");
+    MeshBuilder& mesh = out.mesh;
+    mesh.clear();
+    float step = ROAD_STEP;
+    float startZ = TRACK_START_Z - chunkIndex * CHUNK_LENGTH;
+    float endZ = std::max(startZ - CHUNK_LENGTH, -trackLength);
 
     float halfW = ROAD_WIDTH / 2.0f;
 
+    // 텍스처 v 좌표는 청크 시작 기준으로 정수만큼 빼서 작게 유지 (GL_REPEAT 이라 결과는 같고 half 정밀도 유지)
+    float vBase = floorf(-startZ * 0.1f);
+
     // 높이 설정
     float roadY = -0.5f;
     float walkY = -0.3f;
 
-    for (float z = startZ; z > endZ; z -= step) {
+    // 구간 경계 z 들의 중심 X 를 한 번에 계산 (구간 k 는 centers[k] ~ centers[k + 1])
+    float zs[SEGMENTS_PER_CHUNK + 1] = { 0.0f };
+    float centers[SEGMENTS_PER_CHUNK + 1] = { 0.0f };
+    int segments = 0;
+    float zEdge = startZ;
+    for (; zEdge > endZ && segments < SEGMENTS_PER_CHUNK; zEdge -= step) zs[segments++] = zEdge;
+    zs[segments] = zEdge;
+    trackCenterXBatch(mapType, zs, centers, segments + 1);
+
+    for (int k = 0; k < segments; ++k) {
+        float z = zs[k];
         float zNext = z - step;
 
-        float cxCurrent = getRoadCenterX(z, mapType);
-        float cxNext = getRoadCenterX(zNext, mapType);
+        float cxCurrent = centers[k];
+        float cxNext = centers[k + 1];
         float ny = 1.0f;
 
-        float v1 = -z * 0.1f;
-        float v2 = -zNext * 0.1f;
+        float v1 = -z * 0.1f - vBase;
+        float v2 = -zNext * 0.1f - vBase;
 
         // --- [1] 도로 (Road) ---
         // Quad 1
-        v.insert(v.end(), { cxCurrent - halfW, roadY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxCurrent + halfW, roadY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext + halfW,    roadY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent - halfW, roadY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxCurrent + halfW, roadY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext + halfW,    roadY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
         // Quad 2
-        v.insert(v.end(), { cxCurrent - halfW, roadY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext + halfW,    roadY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
-        v.insert(v.end(), { cxNext - halfW,    roadY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent - halfW, roadY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext + halfW,    roadY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxNext - halfW,    roadY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
     }
 
-    // 도로 정점 개수 저장
-    vertexCountRoad = v.size() / 11;
+    // 도로 인덱스 개수 저장
+    out.roadIndexCount = (int)mesh.indices.size();
 
-    for (float z = startZ; z > endZ; z -= step) {
+    for (int k = 0; k < segments; ++k) {
+        float z = zs[k];
         float zNext = z - step;
-        float cxCurrent = getRoadCenterX(z, mapType);
-        float cxNext = getRoadCenterX(zNext, mapType);
+        float cxCurrent = centers[k];
+        float cxNext = centers[k + 1];
         float ny = 1.0f;
-        float v1 = -z * 0.1f;
-        float v2 = -zNext * 0.1f;
+        float v1 = -z * 0.1f - vBase;
+        float v2 = -zNext * 0.1f - vBase;
 
         // --- [2] 왼쪽 인도 (Sidewalk Left) ---
         // Y값을 walkY(-0.3f)로 올림
-        v.insert(v.end(), { cxCurrent - halfW - SIDEWALK_WIDTH, walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxCurrent - halfW,                  walkY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext - halfW,                     walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
-        v.insert(v.end(), { cxCurrent - halfW - SIDEWALK_WIDTH, walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext - halfW,                     walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
-        v.insert(v.end(), { cxNext - halfW - SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent - halfW - SIDEWALK_WIDTH, walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxCurrent - halfW,                  walkY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext - halfW,                     walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent - halfW - SIDEWALK_WIDTH, walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext - halfW,                     walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxNext - halfW - SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
 
         // --- [3] 오른쪽 인도 (Sidewalk Right) ---
-        v.insert(v.end(), { cxCurrent + halfW,                  walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxCurrent + halfW + SIDEWALK_WIDTH, walkY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext + halfW + SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
-        v.insert(v.end(), { cxCurrent + halfW,                  walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
-        v.insert(v.end(), { cxNext + halfW + SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
-        v.insert(v.end(), { cxNext + halfW,                     walkY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent + halfW,                  walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxCurrent + halfW + SIDEWALK_WIDTH, walkY, z,      1,1,1,  1.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext + halfW + SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxCurrent + halfW,                  walkY, z,      1,1,1,  0.0f, v1,   0, ny, 0 });
+        mesh.add({ cxNext + halfW + SIDEWALK_WIDTH,    walkY, zNext,  1,1,1,  1.0f, v2,   0, ny, 0 });
+        mesh.add({ cxNext + halfW,                     walkY, zNext,  1,1,1,  0.0f, v2,   0, ny, 0 });
 
         // --- [4] 연석 (Curb) - 도로와 인도 사이 옆면 ---
         // 왼쪽 턱 옆면
-        v.insert(v.end(), { cxCurrent - halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
-        v.insert(v.end(), { cxCurrent - halfW, walkY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
-        v.insert(v.end(), { cxNext - halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
-        v.insert(v.end(), { cxCurrent - halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
-        v.insert(v.end(), { cxNext - halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
-        v.insert(v.end(), { cxNext - halfW,    roadY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxCurrent - halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxCurrent - halfW, walkY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxNext - halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxCurrent - halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxNext - halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
+        mesh.add({ cxNext - halfW,    roadY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,   1, 0, 0 });
 
         // 오른쪽 턱 옆면
-        v.insert(v.end(), { cxCurrent + halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
-        v.insert(v.end(), { cxCurrent + halfW, walkY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
-        v.insert(v.end(), { cxNext + halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
-        v.insert(v.end(), { cxCurrent + halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
-        v.insert(v.end(), { cxNext + halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
-        v.insert(v.end(), { cxNext + halfW,    roadY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxCurrent + halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxCurrent + halfW, walkY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxNext + halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxCurrent + halfW, roadY, z,      0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxNext + halfW,    walkY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+        mesh.add({ cxNext + halfW,    roadY, zNext,  0.5f,0.5f,0.5f,  0.0f, 0.0f,  -1, 0, 0 });
+    }
+
+    // 전체 인덱스 개수에서 도로 인덱스 개수를 뺀 것이 나머지(인도+턱) 개수
+    out.sidewalkIndexCount = (int)mesh.indices.size() - out.roadIndexCount;
+
+    // 청크 안의 가로등 (LAMP_SPACING 간격, 도로 끝 전까지)
+    float lampZs[LAMPS_PER_CHUNK] = { 0.0f };
+    float lampCenters[LAMPS_PER_CHUNK] = { 0.0f };
+    int lamps = 0;
+    while (lamps < LAMPS_PER_CHUNK && startZ - lamps * LAMP_SPACING > endZ) {
+        lampZs[lamps] = startZ - lamps * LAMP_SPACING;
+        lamps++;
+    }
+    trackCenterXBatch(mapType, lampZs, lampCenters, lamps);
+
+    out.lampCount = 0;
+    for (int i = 0; i < lamps; ++i) {
+        float z = lampZs[i];
+        float cx = lampCenters[i];
+        float tx = cx - (ROAD_WIDTH / 2.0f) - 0.5f;
+        out.lampModels[i] = Mat4::translation(tx, -0.5f, z);
+
+        LampLight& light = out.lights[i];
+        light.x = cx - 2.5f + 1.1f;
+        light.y = 2.7f;
+        light.z = z;
+        light.radius = LAMP_LIGHT_RADIUS;
+        out.lampCount++;
     }
+}
 
-    // 전체 정점 개수에서 도로 정점 개수를 뺀 것이 나머지(인도+턱) 개수
-    vertexCountSidewalk = (v.size() / 11) - vertexCountRoad;
+// --- 클러스터 조명 ---
+GLuint createTextureBuffer(GLuint* buffer, GLenum format) {
+    GLuint tex;
+    glGenBuffers(1, buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, *buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_BUFFER, tex);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, *buffer);
+    return tex;
+}
 
-    if (bgVAO == 0) glGenVertexArrays(1, &bgVAO);
-    if (bgVBO == 0) glGenBuffers(1, &bgVBO);
+// 텍스처 버퍼 생성 + 텍스처 유닛 연결 (시작 시 한 번, initRoadStreaming 이 가로등 TBO 크기를 잡기 전에)
+// 셰이더와 무관하므로 씬 쉐이더 로딩을 기다리지 않는다
+void initClusterLighting() {
+    lightDataTex = createTextureBuffer(&lightDataTBO, GL_RGBA32F);
+    clusterTex = createTextureBuffer(&clusterTBO, GL_RG32UI);
+    lightIndexTex = createTextureBuffer(&lightIndexTBO, GL_R32UI);
+
+    glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_BUFFER, lightDataTex);
+    glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_BUFFER, clusterTex);
+    glActiveTexture(GL_TEXTURE3); glBindTexture(GL_TEXTURE_BUFFER, lightIndexTex);
+    glActiveTexture(GL_TEXTURE0);
+}
 
+// 씬 쉐이더가 준비된 뒤: 샘플러를 위 텍스처 유닛에 연결
+void initClusterSamplers() {
+    glUseProgram(shaderProgramID);
+    glUniform1i(glGetUniformLocation(shaderProgramID, "lightData"), 1);
+    glUniform1i(glGetUniformLocation(shaderProgramID, "clusterTable"), 2);
+    glUniform1i(glGetUniformLocation(shaderProgramID, "lightIndices"), 3);
+
+    sceneUniforms.clusterDims[0] = CLUSTER_X;
+    sceneUniforms.clusterDims[1] = CLUSTER_Y;
+    sceneUniforms.clusterDims[2] = CLUSTER_Z;
+    sceneUniforms.clusterDims[3] = 0;
+}
+
+// 가로등 하나 -> TBO texel 3개 (위치+반경, 색, 감쇠 계수)
+const int LAMP_TEXEL_FLOATS = 12;
+void packLampLight(const LampLight& l, float* out) {
+    float texels[LAMP_TEXEL_FLOATS] = { l.x, l.y, l.z, l.radius,
+                                        1.0f, 0.9f, 0.6f, 0.0f,
+                                        1.0f, 0.09f, 0.032f, 0.0f };
+    memcpy(out, texels, sizeof(texels));
+}
+
+// 청크 슬롯 하나의 가로등을 GPU 에 올림
+void uploadLampLights(int slot) {
+    float data[LAMPS_PER_CHUNK * LAMP_TEXEL_FLOATS];
+    for (int i = 0; i < LAMPS_PER_CHUNK; ++i) {
+        packLampLight(lampLights[slot * LAMPS_PER_CHUNK + i], data + i * LAMP_TEXEL_FLOATS);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, lightDataTBO);
+    glBufferSubData(GL_TEXTURE_BUFFER, slot * sizeof(data), sizeof(data), data);
+}
+
+// slice 하나에 대해 타일별 조명 목록 작성
+void assignSlice(int slice, float tanHalfX, float tanHalfY, float logRatio) {
+    ClusterSlice& out = clusterSlices[slice];
+    memset(out.counts, 0, sizeof(out.counts));
+
+    float sliceNear = CAMERA_NEAR * expf(logRatio * slice / CLUSTER_Z);
+    float sliceFar = CAMERA_NEAR * expf(logRatio * (slice + 1) / CLUSTER_Z);
+
+    for (const auto& l : visibleLights) {
+        float dMin = std::max(l.depth - l.radius, sliceNear);
+        float dMax = std::min(l.depth + l.radius, sliceFar);
+        if (dMin > dMax) continue;
+
+        // 구의 xy 범위를 slice 의 가까운/먼 깊이에 투영해서 양쪽을 모두 덮는 타일 범위 (보수적)
+        float x0 = std::min((l.x - l.radius) / (dMin * tanHalfX), (l.x - l.radius) / (dMax * tanHalfX));
+        float x1 = std::max((l.x + l.radius) / (dMin * tanHalfX), (l.x + l.radius) / (dMax * tanHalfX));
+        float y0 = std::min((l.y - l.radius) / (dMin * tanHalfY), (l.y - l.radius) / (dMax * tanHalfY));
+        float y1 = std::max((l.y + l.radius) / (dMin * tanHalfY), (l.y + l.radius) / (dMax * tanHalfY));
+        if (x1 < -1.0f || x0 > 1.0f || y1 < -1.0f || y0 > 1.0f) continue;
+
+        int tx0 = std::max(0, (int)((x0 * 0.5f + 0.5f) * CLUSTER_X));
+        int tx1 = std::min(CLUSTER_X - 1, (int)((x1 * 0.5f + 0.5f) * CLUSTER_X));
+        int ty0 = std::max(0, (int)((y0 * 0.5f + 0.5f) * CLUSTER_Y));
+        int ty1 = std::min(CLUSTER_Y - 1, (int)((y1 * 0.5f + 0.5f) * CLUSTER_Y));
+
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                int tile = ty * CLUSTER_X + tx;
+                if (out.counts[tile] < MAX_LIGHTS_PER_CLUSTER) {
+                    out.lights[tile][out.counts[tile]++] = l.index;
+                }
+            }
+        }
+    }
+}
+
+// 이번 프레임의 view 행렬 기준으로 가로등을 클러스터에 배정하고 GPU 에 올림
+void buildLightClusters(const Mat4& view) {
+    PROFILE_SCOPE("LightClusters");
+    // 1) 카메라 공간 변환 + 시야 거리 밖 가로등 제거
+    visibleLights.clear();
+    for (size_t i = 0; i < lampLights.size(); ++i) {
+        const LampLight& l = lampLights[i];
+        if (l.radius <= 0.0f) continue; // 빈 슬롯
+        Vec3 p = view.transformPoint(Vec3(l.x, l.y, l.z));
+        float depth = -p.z;
+        if (depth + l.radius < CAMERA_NEAR || depth - l.radius > CAMERA_FAR) continue;
+
+        ViewLight v;
+        v.x = p.x; v.y = p.y; v.depth = depth; v.radius = l.radius;
+        v.index = (unsigned int)i;
+        visibleLights.push_back(v);
+    }
+
+    // 2) slice 단위로 나눠 작업 스레드에서 배정
+    float tanHalfY = tanf(CAMERA_FOV / 2.0f);
+    float tanHalfX = tanHalfY * CAMERA_ASPECT;
+    float logRatio = logf(CAMERA_FAR / CAMERA_NEAR);
+    workerPool->parallelFor(CLUSTER_Z, [&](int begin, int end) {
+        for (int slice = begin; slice < end; ++slice) assignSlice(slice, tanHalfX, tanHalfY, logRatio);
+    });
+
+    // 3) 클러스터 테이블 + 인덱스 목록으로 합치기
+    clusterLightIndices.clear();
+    for (int slice = 0; slice < CLUSTER_Z; ++slice) {
+        const ClusterSlice& src = clusterSlices[slice];
+        for (int tile = 0; tile < CLUSTER_TILES; ++tile) {
+            int cluster = slice * CLUSTER_TILES + tile;
+            clusterTable[cluster * 2 + 0] = (unsigned int)clusterLightIndices.size();
+            clusterTable[cluster * 2 + 1] = (unsigned int)src.counts[tile];
+            clusterLightIndices.insert(clusterLightIndices.end(), src.lights[tile], src.lights[tile] + src.counts[tile]);
+        }
+    }
+    if (clusterLightIndices.empty()) clusterLightIndices.push_back(0);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, clusterTBO);
+    glBufferData(GL_TEXTURE_BUFFER, clusterTable.size() * sizeof(unsigned int), clusterTable.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, lightIndexTBO);
+    glBufferData(GL_TEXTURE_BUFFER, clusterLightIndices.size() * sizeof(unsigned int), clusterLightIndices.data(), GL_STREAM_DRAW);
+
+    // 셰이더에서 gl_FragCoord / 깊이로 클러스터 번호를 구하는 데 필요한 값
+    sceneUniforms.clusterParams[0] = (float)winWidth / CLUSTER_X;
+    sceneUniforms.clusterParams[1] = (float)winHeight / CLUSTER_Y;
+    sceneUniforms.clusterParams[2] = CLUSTER_Z / logRatio;
+    sceneUniforms.clusterParams[3] = CLUSTER_Z * logf(CAMERA_NEAR) / logRatio;
+}
+
+// --- 도로 스트리밍 ---
+// 링 버퍼, 가로등 인스턴스 버퍼 생성 (시작 시 한 번)
+void initRoadStreaming() {
+    glGenVertexArrays(1, &bgVAO);
+    glGenBuffers(1, &bgVBO);
+    glGenBuffers(1, &bgEBO);
     glBindVertexArray(bgVAO);
     glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
-    glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)CHUNK_RING_SIZE * CHUNK_MAX_VERTICES * sizeof(PackedVertex), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bgEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)CHUNK_RING_SIZE * CHUNK_MAX_INDICES * sizeof(uint16_t), NULL, GL_DYNAMIC_DRAW);
+    setupPackedVertexAttribs();
+
+    // 가로등 인스턴스 행렬 (빈 슬롯은 0 행렬 -> 면적 0 으로 그려지지 않음)
+    std::vector<float> zero(LAMP_INSTANCE_COUNT * 16, 0.0f);
+    glGenBuffers(1, &lampInstanceVBO);
+    glBindVertexArray(lightVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lampInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, zero.size() * sizeof(float), zero.data(), GL_DYNAMIC_DRAW);
+
+    // mat4 는 vec4 4개 (location 4~7), 인스턴스마다 한 번씩 진행
+    int stride = 16 * sizeof(float);
+    for (int col = 0; col < 4; ++col) {
+        glVertexAttribPointer(4 + col, 4, GL_FLOAT, GL_FALSE, stride, (void*)(col * 4 * sizeof(float)));
+        glEnableVertexAttribArray(4 + col);
+        glVertexAttribDivisor(4 + col, 1);
+    }
 
-    int stride = 11 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float))); glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float))); glEnableVertexAttribArray(3);
+    lampLights.assign(LAMP_INSTANCE_COUNT, LampLight());
+    std::vector<float> noLights(LAMP_INSTANCE_COUNT * LAMP_TEXEL_FLOATS, 0.0f);
+    glBindBuffer(GL_TEXTURE_BUFFER, lightDataTBO);
+    glBufferData(GL_TEXTURE_BUFFER, noLights.size() * sizeof(float), noLights.data(), GL_DYNAMIC_DRAW);
 }
 
-// 피니시라인 생성 함수
-void initFinishLine(int mapType) {
-    std::vector<float> v;
+int getChunkCount() {
+    return (int)ceilf((TRACK_START_Z + trackLength) / CHUNK_LENGTH);
+}
+
+int getChunkIndexAt(float z) {
+    return (int)floorf((TRACK_START_Z - z) / CHUNK_LENGTH);
+}
+
+// 슬롯 비우기 (그리기에서 빠지고 가로등도 꺼짐)
+void clearChunkSlot(int slot) {
+    chunkSlots[slot] = ChunkSlot();
+
+    float zero[LAMPS_PER_CHUNK * 16] = { 0.0f };
+    glBindBuffer(GL_ARRAY_BUFFER, lampInstanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(zero), sizeof(zero), zero);
+    for (int i = 0; i < LAMPS_PER_CHUNK; ++i) lampLights[slot * LAMPS_PER_CHUNK + i] = LampLight();
+    uploadLampLights(slot);
+}
+
+// 완성된 청크를 슬롯에 업로드
+void uploadChunk(int slot, const RoadChunk& chunk) {
+    // 인덱스는 청크 안 기준 (그릴 때 슬롯 시작 정점을 base vertex 로 더함)
+    glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)slot * CHUNK_MAX_VERTICES * sizeof(PackedVertex),
+        chunk.mesh.vertices.size() * sizeof(PackedVertex), chunk.mesh.vertices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bgEBO); // 지금 바인딩된 VAO 의 인덱스 버퍼를 바꾸지 않도록
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)slot * CHUNK_MAX_INDICES * sizeof(uint16_t),
+        chunk.mesh.indices.size() * sizeof(uint16_t), chunk.mesh.indices.data());
+
+    float models[LAMPS_PER_CHUNK * 16] = { 0.0f };
+    for (int i = 0; i < chunk.lampCount; ++i) memcpy(models + i * 16, chunk.lampModels[i].data(), 16 * sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER, lampInstanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(models), sizeof(models), models);
+
+    for (int i = 0; i < LAMPS_PER_CHUNK; ++i) {
+        lampLights[slot * LAMPS_PER_CHUNK + i] = (i < chunk.lampCount) ? chunk.lights[i] : LampLight();
+    }
+    uploadLampLights(slot);
+
+    chunkSlots[slot].chunkIndex = chunk.index;
+    chunkSlots[slot].roadIndexCount = chunk.roadIndexCount;
+    chunkSlots[slot].sidewalkIndexCount = chunk.sidewalkIndexCount;
+}
+
+// 작업 스레드에 청크 생성 요청
+void requestChunk(int chunkIndex) {
+    pendingChunks.push_back(chunkIndex);
+    int mapType = selectedMap, generation = streamGeneration;
+    float length = trackLength;
+    workerPool->submit([mapType, chunkIndex, generation, length]() {
+        std::unique_ptr<RoadChunk> chunk(new RoadChunk());
+        chunk->mapType = mapType;
+        chunk->index = chunkIndex;
+        chunk->generation = generation;
+        generateRoadChunk(mapType, chunkIndex, length, *chunk);
+
+        std::lock_guard<std::mutex> lock(readyChunksMutex);
+        readyChunks.push_back(std::move(chunk));
+    });
+}
+
+bool isChunkWanted(int chunkIndex, int first, int last) {
+    return chunkIndex >= first && chunkIndex <= last;
+}
+
+// 매 프레임: 완성된 청크 업로드, 자동차 주변에 필요한 청크 요청, 지나간 청크 제거
+void updateRoadStreaming(float z) {
+    PROFILE_SCOPE("Streaming");
+    int first = std::max(0, getChunkIndexAt(z) - CHUNKS_BEHIND);
+    int last = std::min(getChunkCount() - 1, first + CHUNK_RING_SIZE - 1);
+
+    // 1) 범위를 벗어난 슬롯 비우기
+    for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) {
+        int index = chunkSlots[slot].chunkIndex;
+        if (index >= 0 && !isChunkWanted(index, first, last)) clearChunkSlot(slot);
+    }
+
+    // 2) 작업 스레드가 끝낸 청크를 빈 슬롯에 업로드
+    std::vector<std::unique_ptr<RoadChunk>> done;
+    {
+        std::lock_guard<std::mutex> lock(readyChunksMutex);
+        done.swap(readyChunks);
+    }
+    for (auto& chunk : done) {
+        if (chunk->generation != streamGeneration) continue; // 이전 맵의 결과
+        pendingChunks.erase(std::remove(pendingChunks.begin(), pendingChunks.end(), chunk->index), pendingChunks.end());
+        if (!isChunkWanted(chunk->index, first, last)) continue;
+        for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) {
+            if (chunkSlots[slot].chunkIndex < 0) { uploadChunk(slot, *chunk); break; }
+        }
+    }
+
+    // 3) 아직 없는 청크 요청
+    for (int index = first; index <= last; ++index) {
+        bool resident = false;
+        for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) {
+            if (chunkSlots[slot].chunkIndex == index) { resident = true; break; }
+        }
+        if (resident) continue;
+        if (std::find(pendingChunks.begin(), pendingChunks.end(), index) != pendingChunks.end()) continue;
+        requestChunk(index);
+    }
+}
+
+// 맵 선택 시: 링을 비우고 출발 지점 주변 청크는 바로 만들어 둠 (레이스 도중이 아니라 시작 전에만 동기 생성)
+void resetRoadStreaming(int mapType) {
+    streamGeneration++;
+    pendingChunks.clear();
+    for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) clearChunkSlot(slot);
+
+    int last = std::min(getChunkCount() - 1, CHUNK_RING_SIZE - 1);
+    RoadChunk chunk;
+    for (int index = 0; index <= last; ++index) {
+        chunk.mapType = mapType;
+        chunk.index = index;
+        chunk.generation = streamGeneration;
+        generateRoadChunk(mapType, index, trackLength, chunk);
+        uploadChunk(index, chunk);
+    }
+}
+
+// 올라와 있는 청크의 도로 / 인도를 각각 draw call 하나로 그림
+void drawRoadChunks() {
+    const void* roadOffsets[CHUNK_RING_SIZE];
+    const void* sidewalkOffsets[CHUNK_RING_SIZE];
+    GLsizei roadCounts[CHUNK_RING_SIZE], sidewalkCounts[CHUNK_RING_SIZE];
+    GLint baseVertices[CHUNK_RING_SIZE];
+    int n = 0;
+    for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) {
+        if (chunkSlots[slot].chunkIndex < 0) continue;
+        size_t firstIndex = (size_t)slot * CHUNK_MAX_INDICES;
+        roadOffsets[n] = (const void*)(firstIndex * sizeof(uint16_t));
+        roadCounts[n] = chunkSlots[slot].roadIndexCount;
+        sidewalkOffsets[n] = (const void*)((firstIndex + chunkSlots[slot].roadIndexCount) * sizeof(uint16_t));
+        sidewalkCounts[n] = chunkSlots[slot].sidewalkIndexCount;
+        baseVertices[n] = slot * CHUNK_MAX_VERTICES;
+        n++;
+    }
+    if (n == 0) return;
+
+    glBindVertexArray(bgVAO);
+
+    // 1) 도로 그리기
+    glBindTexture(GL_TEXTURE_2D, roadTextureID);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, roadCounts, GL_UNSIGNED_SHORT, roadOffsets, n, baseVertices);
+    drawCallCount++;
+
+    // 2) 인도 그리기
+    glBindTexture(GL_TEXTURE_2D, dirtTextureID);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, sidewalkCounts, GL_UNSIGNED_SHORT, sidewalkOffsets, n, baseVertices);
+    drawCallCount++;
+}
+
+// 피니시라인 메시 생성 (GL 호출 없음, 맵 준비 작업 스레드에서도 사용)
+const int FINISH_LINE_MAX_VERTICES = 6; // 미리 잡아 두는 버퍼 크기
+const int FINISH_LINE_MAX_INDICES = 6;
+
+void buildFinishLine(int mapType, MeshBuilder& mesh) {
+    mesh.clear();
 
-    float finishZ = FINISH_LINE_Z;
-    float centerX = getRoadCenterX(finishZ, mapType);
+    float finishZ = getFinishLineZ(trackLength);
+    float centerX = getTrackSampler(mapType).centerX(finishZ);
     float halfW = ROAD_WIDTH / 2.0f;
     float finishY = -0.48f; // 도로보다 약간 위에 띄워서 그려짐
 
@@ -405,32 +1022,44 @@ void initFinishLine(int mapType) {
     float ny = 1.0f; // 법선 벡터 (위를 향함)
 
     // 첫 번째 삼각형
-    v.insert(v.end(), { x1, finishY, z1,  1.0f, 1.0f, 0.0f,  0.0f, 0.0f,  0, ny, 0 });
-    v.insert(v.end(), { x2, finishY, z1,  1.0f, 1.0f, 0.0f,  1.0f, 0.0f,  0, ny, 0 });
-    v.insert(v.end(), { x2, finishY, z2,  1.0f, 1.0f, 0.0f,  1.0f, 1.0f,  0, ny, 0 });
+    mesh.add({ x1, finishY, z1,  1.0f, 1.0f, 0.0f,  0.0f, 0.0f,  0, ny, 0 });
+    mesh.add({ x2, finishY, z1,  1.0f, 1.0f, 0.0f,  1.0f, 0.0f,  0, ny, 0 });
+    mesh.add({ x2, finishY, z2,  1.0f, 1.0f, 0.0f,  1.0f, 1.0f,  0, ny, 0 });
 
     // 두 번째 삼각형
-    v.insert(v.end(), { x1, finishY, z1,  1.0f, 1.0f, 0.0f,  0.0f, 0.0f,  0, ny, 0 });
-    v.insert(v.end(), { x2, finishY, z2,  1.0f, 1.0f, 0.0f,  1.0f, 1.0f,  0, ny, 0 });
-    v.insert(v.end(), { x1, finishY, z2,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f,  0, ny, 0 });
+    mesh.add({ x1, finishY, z1,  1.0f, 1.0f, 0.0f,  0.0f, 0.0f,  0, ny, 0 });
+    mesh.add({ x2, finishY, z2,  1.0f, 1.0f, 0.0f,  1.0f, 1.0f,  0, ny, 0 });
+    mesh.add({ x1, finishY, z2,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f,  0, ny, 0 });
 
-    if (finishLineVAO == 0) glGenVertexArrays(1, &finishLineVAO);
-    if (finishLineVBO == 0) glGenBuffers(1, &finishLineVBO);
+}
 
+// 피니시라인 버퍼 (맵마다 다시 만들지 않고 크기를 고정해서 한 번만 생성)
+void initFinishLineBuffers() {
+    glGenVertexArrays(1, &finishLineVAO);
+    glGenBuffers(1, &finishLineVBO);
+    glGenBuffers(1, &finishLineEBO);
     glBindVertexArray(finishLineVAO);
     glBindBuffer(GL_ARRAY_BUFFER, finishLineVBO);
-    glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, FINISH_LINE_MAX_VERTICES * sizeof(PackedVertex), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, finishLineEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, FINISH_LINE_MAX_INDICES * sizeof(uint16_t), NULL, GL_DYNAMIC_DRAW);
+    setupPackedVertexAttribs();
+}
 
-    int stride = 11 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float))); glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float))); glEnableVertexAttribArray(3);
+// 피니시라인 생성 후 바로 업로드 (동기 경로: 벤치마크 등)
+void initFinishLine(int mapType) {
+    MeshBuilder mesh;
+    buildFinishLine(mapType, mesh);
+    glBindBuffer(GL_ARRAY_BUFFER, finishLineVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, mesh.vertices.size() * sizeof(PackedVertex), mesh.vertices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, finishLineEBO); // VAO 의 인덱스 버퍼 바인딩을 건드리지 않도록
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, mesh.indices.size() * sizeof(uint16_t), mesh.indices.data());
+    finishLineIndexCount = (int)mesh.indices.size();
 }
 
-// 큐브/오브젝트 생성 함수
-void initCubeObj(GLuint* vao, GLuint* vbo, bool isCar) {
-    std::vector<float> v;
+// 큐브/오브젝트 생성 함수 (인덱스 개수 반환)
+int initCubeObj(GLuint* vao, GLuint* vbo, GLuint* ebo, bool isCar) {
+    MeshBuilder mesh;
 
     // 원통 헬퍼
     auto addCylinder = [&](float x, float y, float z, float radius, float height, float r, float g, float b) {
@@ -443,12 +1072,12 @@ void initCubeObj(GLuint* vao, GLuint* vbo, bool isCar) {
             float ny1 = cosf(angle1); float nz1 = sinf(angle1);
             float ny2 = cosf(angle2); float nz2 = sinf(angle2);
 
-            v.insert(v.end(), { x - height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
-            v.insert(v.end(), { x + height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
-            v.insert(v.end(), { x + height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
-            v.insert(v.end(), { x - height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
-            v.insert(v.end(), { x + height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
-            v.insert(v.end(), { x - height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
+            mesh.add({ x - height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
+            mesh.add({ x + height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
+            mesh.add({ x + height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
+            mesh.add({ x - height / 2, y + y1, z + z1, r, g, b, 0, 0, 0, ny1, nz1 });
+            mesh.add({ x + height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
+            mesh.add({ x - height / 2, y + y2, z + z2, r, g, b, 0, 0, 0, ny2, nz2 });
         }
         };
 
@@ -468,10 +1097,10 @@ void initCubeObj(GLuint* vao, GLuint* vbo, bool isCar) {
         for (int i = 0; i < 6; ++i) {
             for (int j = 0; j < 6; ++j) {
                 int idx = indices[j];
-                v.push_back(pos[i][idx][0]); v.push_back(pos[i][idx][1]); v.push_back(pos[i][idx][2]);
-                v.push_back(r); v.push_back(g); v.push_back(b);
-                v.push_back(0.0f); v.push_back(0.0f);
-                v.push_back(normals[i][0]); v.push_back(normals[i][1]); v.push_back(normals[i][2]);
+                mesh.add({ pos[i][idx][0], pos[i][idx][1], pos[i][idx][2],
+                           r, g, b,
+                           0.0f, 0.0f,
+                           normals[i][0], normals[i][1], normals[i][2] });
             }
         }
         };
@@ -495,102 +1124,594 @@ void initCubeObj(GLuint* vao, GLuint* vbo, bool isCar) {
         addFace(1.1f, 2.7f, 0.0f, 0.3f, 0.3f, 0.3f, 1.0f, 1.0f, 0.5f);
     }
 
-    glGenVertexArrays(1, vao);
-    glGenBuffers(1, vbo);
-    glBindVertexArray(*vao);
-    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
-    glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_STATIC_DRAW);
-    int stride = 11 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float))); glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float))); glEnableVertexAttribArray(3);
+    uploadMesh(mesh, vao, vbo, ebo);
+    return (int)mesh.indices.size();
+}
+
+// --- 에셋 로딩 ---
+// 파일 읽기 + 이미지 디코딩은 작업 스레드에서 병렬로 하고, GL 업로드는 메인 스레드에서 프레임마다 조금씩 한다.
+// 그동안은 LOADING 화면에 진행률을 그린다. (텍스트 쉐이더와 글리프 아틀라스는 이 화면에 필요해서 먼저 만듦)
+const float ASSET_UPLOAD_BUDGET_MS = 4.0f; // 한 프레임에 GL 업로드에 쓸 시간 (최소 한 건은 처리)
+
+// 작업 스레드가 준비를 끝낸 에셋 (upload 는 GL 스레드에서 실행)
+struct ReadyAsset {
+    const char* name;
+    std::function<void()> upload;
+};
+
+std::mutex readyAssetsMutex;
+std::vector<ReadyAsset> readyAssets;    // 작업 스레드 -> 메인 스레드
+std::deque<ReadyAsset> assetUploadQueue; // 메인 스레드에서 업로드 대기
+int assetsTotal = 0;
+int assetsUploaded = 0;
+const char* lastAssetName = "";
+
+void queueAssetUpload(const char* name, std::function<void()> upload) {
+    ReadyAsset asset = { name, std::move(upload) };
+    std::lock_guard<std::mutex> lock(readyAssetsMutex);
+    readyAssets.push_back(std::move(asset));
+}
+
+void loadTextureAsync(const char* filename, GLuint* target) {
+    assetsTotal++;
+    workerPool->submit([filename, target]() {
+        std::shared_ptr<DecodedImage> image(new DecodedImage());
+        decodeImage(filename, *image);
+        queueAssetUpload(filename, [filename, target, image]() { *target = uploadTexture(*image, filename); });
+    });
+}
+
+// 쉐이더는 소스 읽기만 작업 스레드에서 (컴파일 / 캐시 로드는 GL 컨텍스트가 있는 스레드에서만 가능)
+void loadProgramAsync(const char* vsFile, const char* fsFile, GLuint* target, void (*onReady)()) {
+    assetsTotal++;
+    workerPool->submit([vsFile, fsFile, target, onReady]() {
+        std::shared_ptr<std::string> vSrc, fSrc;
+        if (char* buf = filetobuf(vsFile)) { vSrc.reset(new std::string(buf)); free(buf); }
+        if (char* buf = filetobuf(fsFile)) { fSrc.reset(new std::string(buf)); free(buf); }
+        queueAssetUpload(vsFile, [vsFile, vSrc, fSrc, target, onReady]() {
+            if (!vSrc || !fSrc) { std::cerr << "Shader file not found!" << std::endl; exit(1); }
+            *target = buildProgram(vsFile, *vSrc, *fSrc);
+            if (onReady) onReady();
+        });
+    });
+}
+
+// 씬 쉐이더가 준비된 뒤: 유니폼 위치 + 유니폼 블록 + 클러스터 조명 텍스처 유닛
+void initSceneProgram() {
+    modelLoc = glGetUniformLocation(shaderProgramID, "model");
+    normalMatrixLoc = glGetUniformLocation(shaderProgramID, "normalMatrix");
+    useTextureLoc = glGetUniformLocation(shaderProgramID, "useTexture");
+    isLightSourceLoc = glGetUniformLocation(shaderProgramID, "isLightSource");
+    useInstancingLoc = glGetUniformLocation(shaderProgramID, "useInstancing");
+    initSceneUniformBlock();
+    initClusterSamplers();
+}
+
+// 모든 에셋 요청 (결과는 updateAssetLoading() 에서 업로드)
+void startAssetLoading() {
+    stbi_set_flip_vertically_on_load(true); // 모든 텍스처 공통 (작업 스레드는 읽기만 함)
+    loadProgramAsync("vertex.glsl", "fragment.glsl", &shaderProgramID, initSceneProgram);
+    loadTextureAsync("road.png", &roadTextureID);
+    loadTextureAsync("dirt.png", &dirtTextureID);
+    currentState = LOADING;
+}
+
+bool assetsLoaded() {
+    return assetsUploaded == assetsTotal;
+}
+
+void requestMapSwitch(int mapType);
+
+// 매 프레임 (LOADING 중): 준비된 에셋을 예산 안에서 업로드하고, 모두 끝나면 메뉴로 (--replay 면 리플레이 맵 준비 시작)
+void updateAssetLoading() {
+    PROFILE_SCOPE("AssetUpload");
+    {
+        std::lock_guard<std::mutex> lock(readyAssetsMutex);
+        for (auto& asset : readyAssets) assetUploadQueue.push_back(std::move(asset));
+        readyAssets.clear();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    while (!assetUploadQueue.empty()) {
+        ReadyAsset asset = std::move(assetUploadQueue.front());
+        assetUploadQueue.pop_front();
+        asset.upload();
+        assetsUploaded++;
+        lastAssetName = asset.name;
+        float spentMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        if (spentMs >= ASSET_UPLOAD_BUDGET_MS) break;
+    }
+    if (assetsLoaded() && currentState == LOADING) {
+        currentState = MENU;
+        if (playbackPending) requestMapSwitch(playbackReplay.header.mapType);
+    }
+}
+
+// 벤치마크처럼 화면 없이 시작할 때: 모두 업로드될 때까지 기다림
+void finishAssetLoading() {
+    while (!assetsLoaded()) {
+        updateAssetLoading();
+        if (!assetsLoaded()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// --- 고스트 ---
+struct GhostInstance {
+    float model[16];
+    float tint[4];
+};
+
+// carVAO 에 인스턴스 속성 연결 (시작 시 한 번). 플레이어 자동차는 useInstancing 0 으로 그리므로 영향 없음
+void initGhostRendering() {
+    glGenBuffers(1, &ghostInstanceVBO);
+    glBindVertexArray(carVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, ghostInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, MAX_GHOSTS * sizeof(GhostInstance), NULL, GL_STREAM_DRAW);
+    int stride = sizeof(GhostInstance);
+    for (int col = 0; col < 4; ++col) {
+        glVertexAttribPointer(4 + col, 4, GL_FLOAT, GL_FALSE, stride, (void*)(col * 4 * sizeof(float)));
+        glEnableVertexAttribArray(4 + col);
+        glVertexAttribDivisor(4 + col, 1);
+    }
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GhostInstance, tint));
+    glEnableVertexAttribArray(8);
+    glVertexAttribDivisor(8, 1);
+    glBindVertexArray(0);
+
+    // 색 배열이 없는 VAO (가로등) 는 이 기본값을 읽음 -> 색 그대로, 불투명
+    glVertexAttrib4f(8, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+// 이 맵의 고스트 리플레이를 연다. 같은 기록은 한 번만 (1위가 개인 최고면 1위로 표시)
+void startGhosts(int map) {
+    for (GhostStream& g : ghosts) g.close();
+    if (!ghostsEnabled) return;
+
+    uint64_t seqs[MAX_GHOSTS] = { 0, 0, 0 };
+    std::vector<RankingRecord> top = leaderboard.topRecords(map, GHOST_TOP_RANK);
+    if (!top.empty()) seqs[GHOST_TOP1] = top.front().seq;
+    if ((int)top.size() == GHOST_TOP_RANK) seqs[GHOST_TOP5] = top.back().seq;
+    float best;
+    if (!ghostPlayerName.empty()) leaderboard.personalBest(map, ghostPlayerName, &best, &seqs[GHOST_PERSONAL_BEST]);
+
+    for (int i = 0; i < MAX_GHOSTS; ++i) {
+        if (seqs[i] == 0 || std::find(seqs, seqs + i, seqs[i]) != seqs + i) continue;
+        // 리플레이가 없는 예전 기록이나 설정이 다른 기록은 조용히 건너뜀
+        ghosts[i].open(replayPathForSeq(seqs[i]), map, simHz, trackLength);
+    }
+}
+
+// 플레이어 틱마다 한 번
+void stepGhosts() {
+    for (GhostStream& g : ghosts) g.step();
+}
+
+// 보간한 고스트 위치를 인스턴스 버퍼에 올리고 그릴 개수를 돌려줌
+int uploadGhostInstances(float alpha) {
+    GhostInstance instances[MAX_GHOSTS];
+    int count = 0;
+    for (int i = 0; i < MAX_GHOSTS; ++i) {
+        if (!ghosts[i].active()) continue;
+        CarState g = ghosts[i].drawState(alpha);
+        Mat4 model = Mat4::translation(g.x, -0.25f, g.z) * Mat4::rotationY(g.angle);
+        memcpy(instances[count].model, model.data(), sizeof(instances[count].model));
+        memcpy(instances[count].tint, GHOST_TINTS[i], sizeof(instances[count].tint));
+        count++;
+    }
+    if (count > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, ghostInstanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(GhostInstance), instances);
+    }
+    return count;
 }
 
 // --- 게임 초기화 ---
-void initGame(int map) {
+// 도로/피니시라인이 GPU 에 올라간 뒤 레이스 시작
+void startRace(int map) {
     selectedMap = map;
-    carX = getRoadCenterX(0.0f, map); // 도로 중앙에서 시작
-    carZ = 0.0f;
-    carAngle = 0.0f;
-    timerStarted = false;
-    startTime = 0;
-    elapsedTime = 0;
-    finishReached = false;
-    initMapBuffer(map);
-    initFinishLine(map); // 피니시라인 생성
+    resetCar(car, map, trackLength);
+    prevCar = car;
+    simAccumulator = 0.0f;
+    renderAlpha = 1.0f;
     currentState = PLAY;
+
+    // 리플레이 맵이면 재생, 아니면 새로 녹화
+    playbackActive = playbackPending && map == playbackReplay.header.mapType;
+    playbackPending = false;
+    playbackFastForward = false;
+    if (playbackActive) playbackCursor.reset(playbackReplay);
+    else raceRecording.begin(map, simHz, trackLength);
+    startGhosts(map);
+}
+
+// 동기 경로: 이 자리에서 도로를 만들어 올리고 바로 시작 (벤치마크). 메뉴에서는 requestMapSwitch() 사용
+void initGame(int map) {
+    resetRoadStreaming(map);
+    initFinishLine(map); // 피니시라인 생성
+    startRace(map);
+}
+
+// 리플레이 재생 종료: 결과를 녹화 당시 결과와 비교해 출력 (충돌이면 GAME OVER, 아니면 메뉴로)
+void endPlayback(StepResult result) {
+    const ReplayHeader& h = playbackReplay.header;
+    printf("Replay: %s %.2f sec (recorded %s %.2f sec)\n", stepResultName(result), car.elapsedTime / 1000.0f,
+        stepResultName((StepResult)h.result), h.elapsedMs / 1000.0f);
+    playbackActive = false;
+    playbackFastForward = false;
+    currentState = (result == STEP_CRASHED) ? GAMEOVER : MENU;
 }
 
-// 키 상태에 따라 자동차 업데이트 및 충돌 체크
+// 키 상태에 따라 자동차를 고정 틱(1 / simHz 초) 하나만큼 업데이트 및 충돌 체크
 void updateCar() {
     if (currentState != PLAY) return;
 
-    float speed = 0.3f;
-    float rotSpeed = 0.02f;
+    CarInput input;
+    if (playbackActive) {
+        if (!playbackCursor.next(input)) { endPlayback(STEP_RUNNING); return; } // 끝나기 전에 녹화가 끊김
+    }
+    else {
+        input.up = specialKeyStates[GLUT_KEY_UP];
+        input.down = specialKeyStates[GLUT_KEY_DOWN];
+        input.left = specialKeyStates[GLUT_KEY_LEFT];
+        input.right = specialKeyStates[GLUT_KEY_RIGHT];
+        raceRecording.record(input);
+    }
 
-    float forwardX = sinf(carAngle);
-    float forwardZ = -cosf(carAngle);
+    prevCar = car;
+    StepResult result = stepCar(car, input, 1.0f / simHz);
+    stepGhosts();
 
-    // 방향키가 입력되면 타이머 시작
-    if (!timerStarted && (specialKeyStates[GLUT_KEY_UP] || specialKeyStates[GLUT_KEY_DOWN] ||
-                          specialKeyStates[GLUT_KEY_LEFT] || specialKeyStates[GLUT_KEY_RIGHT])) {
-        timerStarted = true;
-        startTime = glutGet(GLUT_ELAPSED_TIME);
+    if (result != STEP_RUNNING) {
+        if (playbackActive) { endPlayback(result); return; }
+        raceRecording.finish(result, car.elapsedTime);
+        if (!raceRecording.save(LAST_REPLAY_FILE)) std::cerr << "Failed to save replay" << std::endl;
     }
 
-    if (specialKeyStates[GLUT_KEY_UP]) {
-        carX += speed * forwardX;
-        carZ += speed * forwardZ;
+    if (result == STEP_FINISHED) {
+        // 이름 입력 화면으로 전환
+        recordedTime = car.elapsedTime / 1000.0f;
+        currentInputName = "";
+        currentState = NAME_INPUT;
     }
-    if (specialKeyStates[GLUT_KEY_DOWN]) {
-        carX -= speed * forwardX;
-        carZ -= speed * forwardZ;
+    else if (result == STEP_CRASHED) {
+        // 도로를 벗어남 -> 인도 충돌
+        currentState = GAMEOVER;
     }
-    if (specialKeyStates[GLUT_KEY_LEFT]) {
-        carAngle -= rotSpeed;
+}
+
+// --- 맵 전환 ---
+// 메뉴에서 맵을 고르면 작업 스레드가 첫 링 버퍼 분량의 청크 + 피니시라인을 미리 잡아 둔 arena 에 만들고,
+// 메인 스레드는 그것을 staging 버퍼에 한 번에 복사한 뒤 glCopyBufferSubData 로 GPU 버퍼에 옮긴다.
+// 복사 뒤에 건 fence 가 끝나면 레이스를 시작하고, 그동안 메뉴는 계속 입력을 받는다.
+// 만든 맵은 MAP_CACHE_SIZE 개까지 LRU 로 남겨 두어 같은 맵을 다시 고르면 업로드만 한다.
+const int MAP_CACHE_SIZE = 2;
+
+// 맵 하나의 arena. 배치가 GPU 링 버퍼와 같아서 (슬롯 i = 청크 i) 통째로 복사하면 된다.
+struct PreparedMap {
+    int mapType = 0;
+    bool building = false;          // 작업 스레드가 채우는 중 (메인 스레드만 읽고 씀)
+    bool ready = false;
+    unsigned long long lastUsed = 0;
+    std::vector<PackedVertex> vertices;   // CHUNK_RING_SIZE * CHUNK_MAX_VERTICES
+    std::vector<uint16_t> indices;        // CHUNK_RING_SIZE * CHUNK_MAX_INDICES
+    std::vector<float> lampModels;        // LAMP_INSTANCE_COUNT * 16
+    std::vector<float> lampTexels;        // LAMP_INSTANCE_COUNT * LAMP_TEXEL_FLOATS
+    std::vector<LampLight> lights;
+    ChunkSlot slots[CHUNK_RING_SIZE];
+    MeshBuilder finishLine;
+};
+
+// staging 버퍼 안의 구간 (arena 의 각 배열과 같은 크기)
+size_t alignStaging(size_t offset) { return (offset + 255) & ~(size_t)255; }
+const size_t STAGE_VERTEX_BYTES = (size_t)CHUNK_RING_SIZE * CHUNK_MAX_VERTICES * sizeof(PackedVertex);
+const size_t STAGE_INDEX_BYTES = (size_t)CHUNK_RING_SIZE * CHUNK_MAX_INDICES * sizeof(uint16_t);
+const size_t STAGE_LAMP_MODEL_BYTES = (size_t)LAMP_INSTANCE_COUNT * 16 * sizeof(float);
+const size_t STAGE_LAMP_TEXEL_BYTES = (size_t)LAMP_INSTANCE_COUNT * LAMP_TEXEL_FLOATS * sizeof(float);
+const size_t STAGE_FINISH_VERTEX_BYTES = FINISH_LINE_MAX_VERTICES * sizeof(PackedVertex);
+const size_t STAGE_VERTEX_OFFSET = 0;
+const size_t STAGE_INDEX_OFFSET = alignStaging(STAGE_VERTEX_OFFSET + STAGE_VERTEX_BYTES);
+const size_t STAGE_LAMP_MODEL_OFFSET = alignStaging(STAGE_INDEX_OFFSET + STAGE_INDEX_BYTES);
+const size_t STAGE_LAMP_TEXEL_OFFSET = alignStaging(STAGE_LAMP_MODEL_OFFSET + STAGE_LAMP_MODEL_BYTES);
+const size_t STAGE_FINISH_VERTEX_OFFSET = alignStaging(STAGE_LAMP_TEXEL_OFFSET + STAGE_LAMP_TEXEL_BYTES);
+const size_t STAGE_FINISH_INDEX_OFFSET = alignStaging(STAGE_FINISH_VERTEX_OFFSET + STAGE_FINISH_VERTEX_BYTES);
+const size_t STAGING_SIZE = alignStaging(STAGE_FINISH_INDEX_OFFSET + FINISH_LINE_MAX_INDICES * sizeof(uint16_t));
+
+PreparedMap mapCache[MAP_CACHE_SIZE];
+unsigned long long mapUseCounter = 0;
+std::mutex builtMapsMutex;
+std::vector<int> builtMaps;          // 작업 스레드가 다 채운 mapCache 번호 -> 메인 스레드
+
+GLuint stagingBuffer;
+char* stagingPtr = NULL;             // 영구 매핑 주소 (ARB_buffer_storage 가 없으면 NULL, 업로드마다 map / unmap)
+GLsync mapUploadFence = 0;
+int uploadingEntry = -1;             // fence 를 기다리는 mapCache 번호
+int requestedMap = 0;                // 메뉴에서 고른 맵 (0 이면 전환 중 아님)
+
+// 시작 시 한 번: arena 와 staging 버퍼 할당
+void initMapSwitching() {
+    for (auto& entry : mapCache) {
+        entry.vertices.resize((size_t)CHUNK_RING_SIZE * CHUNK_MAX_VERTICES);
+        entry.indices.resize((size_t)CHUNK_RING_SIZE * CHUNK_MAX_INDICES);
+        entry.lampModels.resize((size_t)LAMP_INSTANCE_COUNT * 16);
+        entry.lampTexels.resize((size_t)LAMP_INSTANCE_COUNT * LAMP_TEXEL_FLOATS);
+        entry.lights.resize(LAMP_INSTANCE_COUNT);
     }
-    if (specialKeyStates[GLUT_KEY_RIGHT]) {
-        carAngle += rotSpeed;
+
+    glGenBuffers(1, &stagingBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+    if (GLEW_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_READ_BUFFER, STAGING_SIZE, NULL, flags);
+        stagingPtr = (char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, STAGING_SIZE, flags);
     }
+    if (!stagingPtr) glBufferData(GL_COPY_READ_BUFFER, STAGING_SIZE, NULL, GL_STREAM_DRAW);
+    initFinishLineBuffers();
+}
 
-    // 타이머가 시작되었고 아직 피니시라인에 도달하지 않았다면 시간 업데이트
-    if (timerStarted && !finishReached) {
-        elapsedTime = glutGet(GLUT_ELAPSED_TIME) - startTime;
+// 작업 스레드: 첫 CHUNK_RING_SIZE 개 청크를 arena 의 해당 슬롯 위치에 채움 (GL 호출 없음)
+void buildPreparedMap(PreparedMap& out, int mapType) {
+    PROFILE_SCOPE("PrepareMap");
+    std::fill(out.lampModels.begin(), out.lampModels.end(), 0.0f);
+    std::fill(out.lights.begin(), out.lights.end(), LampLight());
+
+    RoadChunk chunk;
+    int last = std::min(getChunkCount() - 1, CHUNK_RING_SIZE - 1);
+    for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) {
+        out.slots[slot] = ChunkSlot();
+        if (slot > last) continue;
+        generateRoadChunk(mapType, slot, trackLength, chunk);
+        std::copy(chunk.mesh.vertices.begin(), chunk.mesh.vertices.end(), out.vertices.begin() + (size_t)slot * CHUNK_MAX_VERTICES);
+        std::copy(chunk.mesh.indices.begin(), chunk.mesh.indices.end(), out.indices.begin() + (size_t)slot * CHUNK_MAX_INDICES);
+        for (int i = 0; i < chunk.lampCount; ++i) {
+            int lamp = slot * LAMPS_PER_CHUNK + i;
+            memcpy(&out.lampModels[(size_t)lamp * 16], chunk.lampModels[i].data(), 16 * sizeof(float));
+            out.lights[lamp] = chunk.lights[i];
+        }
+        out.slots[slot].chunkIndex = slot;
+        out.slots[slot].roadIndexCount = chunk.roadIndexCount;
+        out.slots[slot].sidewalkIndexCount = chunk.sidewalkIndexCount;
+    }
+    for (int lamp = 0; lamp < LAMP_INSTANCE_COUNT; ++lamp) {
+        packLampLight(out.lights[lamp], &out.lampTexels[(size_t)lamp * LAMP_TEXEL_FLOATS]);
     }
+    buildFinishLine(mapType, out.finishLine);
+}
 
-    // 피니시라인 도달 체크
-    if (!finishReached && carZ <= FINISH_LINE_Z) {
-        finishReached = true;
-        elapsedTime = glutGet(GLUT_ELAPSED_TIME) - startTime;
+// 이 맵이 준비됐거나 준비 중인 캐시 항목 (없으면 -1)
+int findCachedMap(int mapType) {
+    for (int i = 0; i < MAP_CACHE_SIZE; ++i) {
+        if (mapCache[i].mapType == mapType && (mapCache[i].ready || mapCache[i].building)) return i;
+    }
+    return -1;
+}
 
-        // 이름 입력 화면으로 전환
-        recordedTime = elapsedTime / 1000.0f;
-        currentInputName = "";
-        currentState = NAME_INPUT;
+// 가장 오래 안 쓴 항목을 비워서 작업 스레드에 맵 생성 요청
+void startMapBuild(int mapType) {
+    int victim = -1;
+    for (int i = 0; i < MAP_CACHE_SIZE; ++i) {
+        if (mapCache[i].building || i == uploadingEntry) continue;
+        if (victim < 0 || mapCache[i].lastUsed < mapCache[victim].lastUsed) victim = i;
     }
+    if (victim < 0) return; // 모두 사용 중이면 다음 프레임에 다시 시도
+
+    PreparedMap& entry = mapCache[victim];
+    entry.mapType = mapType;
+    entry.ready = false;
+    entry.building = true;
+    entry.lastUsed = ++mapUseCounter;
+    workerPool->submit([victim, mapType]() {
+        buildPreparedMap(mapCache[victim], mapType);
+        std::lock_guard<std::mutex> lock(builtMapsMutex);
+        builtMaps.push_back(victim);
+    });
+}
 
-    // --- 충돌 체크 (Collision Detection) ---
-    float roadCenter = getRoadCenterX(carZ, selectedMap);
-    float limit = (ROAD_WIDTH / 2.0f) - CAR_COLLISION_RADIUS;
+// staging 버퍼의 구간을 GPU 버퍼로 복사. 대상 버퍼가 그보다 작으면 (초기화 순서가 틀린 경우 등) GL 오류로
+// 조용히 무시되므로, 복사하지 않고 알린다.
+void copyStaged(GLuint target, size_t offset, size_t bytes) {
+    if (bytes == 0) return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+    GLint64 capacity = 0;
+    glGetBufferParameteri64v(GL_COPY_WRITE_BUFFER, GL_BUFFER_SIZE, &capacity);
+    assert((GLint64)bytes <= capacity);
+    if ((GLint64)bytes > capacity) {
+        std::cerr << "Map upload: " << bytes << " bytes do not fit buffer " << target << " (" << capacity << " bytes)" << std::endl;
+        return;
+    }
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)offset, 0, (GLsizeiptr)bytes);
+}
 
-    // 도로 중심과의 거리 계산
-    if (abs(carX - roadCenter) > limit) {
-        // 도로를 벗어남 -> 인도 충돌
-        currentState = GAMEOVER;
+// arena -> staging 복사 한 번 + GPU 안에서 버퍼 복사, 끝나는 시점에 fence
+void beginMapUpload(int index) {
+    PROFILE_SCOPE("MapUpload");
+    const PreparedMap& entry = mapCache[index];
+    size_t finishVertexBytes = entry.finishLine.vertices.size() * sizeof(PackedVertex);
+    size_t finishIndexBytes = entry.finishLine.indices.size() * sizeof(uint16_t);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+    char* dst = stagingPtr;
+    if (!dst) dst = (char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, STAGING_SIZE, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) return; // 매핑 실패: 다음 프레임에 다시 시도
+    memcpy(dst + STAGE_VERTEX_OFFSET, entry.vertices.data(), STAGE_VERTEX_BYTES);
+    memcpy(dst + STAGE_INDEX_OFFSET, entry.indices.data(), STAGE_INDEX_BYTES);
+    memcpy(dst + STAGE_LAMP_MODEL_OFFSET, entry.lampModels.data(), STAGE_LAMP_MODEL_BYTES);
+    memcpy(dst + STAGE_LAMP_TEXEL_OFFSET, entry.lampTexels.data(), STAGE_LAMP_TEXEL_BYTES);
+    memcpy(dst + STAGE_FINISH_VERTEX_OFFSET, entry.finishLine.vertices.data(), finishVertexBytes);
+    memcpy(dst + STAGE_FINISH_INDEX_OFFSET, entry.finishLine.indices.data(), finishIndexBytes);
+    if (!stagingPtr) glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+    copyStaged(bgVBO, STAGE_VERTEX_OFFSET, STAGE_VERTEX_BYTES);
+    copyStaged(bgEBO, STAGE_INDEX_OFFSET, STAGE_INDEX_BYTES);
+    copyStaged(lampInstanceVBO, STAGE_LAMP_MODEL_OFFSET, STAGE_LAMP_MODEL_BYTES);
+    copyStaged(lightDataTBO, STAGE_LAMP_TEXEL_OFFSET, STAGE_LAMP_TEXEL_BYTES);
+    copyStaged(finishLineVBO, STAGE_FINISH_VERTEX_OFFSET, finishVertexBytes);
+    copyStaged(finishLineEBO, STAGE_FINISH_INDEX_OFFSET, finishIndexBytes);
+
+    mapUploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    uploadingEntry = index;
+}
+
+// 업로드가 끝난 맵으로 스트리밍 상태를 맞추고 레이스 시작
+void finishMapUpload(const PreparedMap& entry) {
+    streamGeneration++; // 이전 맵 청크 결과 폐기
+    pendingChunks.clear();
+    for (int slot = 0; slot < CHUNK_RING_SIZE; ++slot) chunkSlots[slot] = entry.slots[slot];
+    lampLights = entry.lights;
+    finishLineIndexCount = (int)entry.finishLine.indices.size();
+    requestedMap = 0;
+    startRace(entry.mapType);
+}
+
+// 메뉴에서 맵 선택 (준비되면 updateMapSwitch() 가 레이스를 시작)
+void requestMapSwitch(int mapType) {
+    requestedMap = mapType;
+    int index = findCachedMap(mapType);
+    if (index >= 0) mapCache[index].lastUsed = ++mapUseCounter;
+    else startMapBuild(mapType);
+}
+
+// 메뉴를 떠나면 전환 취소 (만들던 결과는 캐시에 남음)
+void cancelMapSwitch() {
+    requestedMap = 0;
+}
+
+bool mapSwitchPending() {
+    return requestedMap != 0 || mapUploadFence != 0;
+}
+
+// 매 프레임 (전환 중): 완성된 arena 회수 -> 업로드 -> fence 확인
+void updateMapSwitch() {
+    std::vector<int> built;
+    {
+        std::lock_guard<std::mutex> lock(builtMapsMutex);
+        built.swap(builtMaps);
+    }
+    for (int index : built) {
+        mapCache[index].building = false;
+        mapCache[index].ready = true;
+    }
+
+    if (mapUploadFence) {
+        GLenum status = glClientWaitSync(mapUploadFence, 0, 0); // 기다리지 않고 확인만
+        if (status == GL_TIMEOUT_EXPIRED) return;
+        glDeleteSync(mapUploadFence);
+        mapUploadFence = 0;
+        const PreparedMap& entry = mapCache[uploadingEntry];
+        uploadingEntry = -1;
+        if (entry.mapType == requestedMap && currentState == MENU) finishMapUpload(entry);
+        return;
+    }
+
+    if (requestedMap == 0) return;
+    int index = findCachedMap(requestedMap);
+    if (index < 0) startMapBuild(requestedMap);
+    else if (mapCache[index].ready) beginMapUpload(index);
+}
+
+// 랭킹 화면의 맵 하나 (상위 기록 + 전체 기록 수)
+void drawRankingColumn(int mapType, const char* title, int x) {
+    drawString(title, x, 500);
+    int yPos = 460;
+    std::vector<RankingEntry> top = leaderboard.top(mapType, RANKING_SHOWN);
+    for (size_t i = 0; i < top.size(); i++) {
+        char rankStr[128];
+        sprintf(rankStr, "%d. %-12s %.2f sec", (int)(i + 1), top[i].name.c_str(), top[i].time);
+        drawString(rankStr, x, yPos);
+        yPos -= 30;
+    }
+    char countStr[64];
+    sprintf(countStr, "Total runs: %d", (int)leaderboard.count(mapType));
+    drawString(countStr, x, yPos - 10);
+}
+
+// --- 프로파일러 오버레이 ---
+#if ENABLE_PROFILER
+bool showProfiler = false;              // F3 으로 전환
+const int PROFILER_TRACE_FRAMES = 120;  // F4 로 저장할 프레임 수
+const char* PROFILER_TRACE_FILE = "profile_trace.json";
+
+// 항목별 CPU / GPU 평균 시간을 화면 오른쪽 위에 출력
+void drawProfilerOverlay() {
+    char line[128];
+    int y = 570;
+    sprintf(line, "Frame %.2f ms%s", profiler().averageFrameMs(), profiler().capturing() ? " [trace]" : "");
+    drawString(line, 520, y);
+    drawString("           CPU    GPU", 520, y -= 22);
+    profiler().forEachStat([&](const Profiler::Stat& s) {
+        sprintf(line, "%-10s %5.2f  %5.2f", s.name, s.cpuMs, s.gpuMs);
+        drawString(line, 520, y -= 22);
+    });
+
+    // 화면 상태별 초당 프레임 수 / CPU 사용 시간 (정지 화면은 입력이 있을 때만 그려짐)
+    drawString("state      fps  CPU ms/s", 520, y -= 34);
+    profiler().forEachFrameTag([&](const Profiler::FrameTagStat& t) {
+        double seconds = std::max(t.wallMs / 1000.0, 1.0e-3);
+        sprintf(line, "%-9s %5.1f  %6.2f", t.name, t.frames / seconds, t.busyCpuMs / seconds);
+        drawString(line, 520, y -= 22);
+    });
+}
+
+// 종료 시 상태별 프레임 통계 출력
+void printFrameReport() {
+    profiler().printFrameTags(stdout);
+}
+#endif
+
+// 텍스트 출력 + 화면 교체 (모든 화면 상태의 프레임 끝)
+void finishFrame() {
+#if ENABLE_PROFILER
+    if (showProfiler) drawProfilerOverlay();
+#endif
+    flushText();
+    {
+        PROFILE_SCOPE("Swap");
+        if (!headlessContext) glutSwapBuffers();
     }
+    PROFILE_FRAME(GAME_STATE_NAMES[currentState]);
+}
+
+// 모델 행렬 + 법선 행렬 전송
+// 지금 그리는 물체는 모두 회전 + 이동뿐이라 (rigid) 역행렬 없이 왼쪽 위 3x3 을 그대로 쓴다.
+void setModelMatrix(const Mat4& model, bool rigid = true) {
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.data());
+    Mat3 normal = rigid ? model.upper3x3() : model.normalMatrix();
+    glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, normal.data());
 }
 
 GLvoid drawScene() {
+    PROFILE_FRAME_BEGIN();
+    redrawPending = false;
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (currentState == MENU) {
+    if (currentState == LOADING) {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        const int barWidth = 30;
+        int filled = assetsTotal > 0 ? barWidth * assetsUploaded / assetsTotal : barWidth;
+        char bar[barWidth + 3];
+        bar[0] = '[';
+        for (int i = 0; i < barWidth; ++i) bar[i + 1] = (i < filled) ? '#' : '-';
+        bar[barWidth + 1] = ']';
+        bar[barWidth + 2] = 0;
+        char progress[64];
+        sprintf(progress, "Loading... %d / %d", assetsUploaded, assetsTotal);
+        drawString(progress, 330, 330);
+        drawString(bar, 260, 300);
+        if (assetsUploaded > 0) drawString(lastAssetName, 330, 270);
+        finishFrame();
+        return;
+    }
+    else if (currentState == MENU) {
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         drawString("=== Select Map ===", 320, 350);
         drawString("Press '1' for Map 1 (Gentle Curve)", 250, 300);
         drawString("Press '2' for Map 2 (Complex Curve)", 250, 270);
         drawString("Press 'R' to View Rankings", 280, 240);
-        glutSwapBuffers();
+        drawString(ghostsEnabled ? "Press 'G' to hide Ghosts" : "Press 'G' to show Ghosts", 290, 210);
+        if (requestedMap != 0) {
+            char preparing[64];
+            sprintf(preparing, "Preparing Map %d...", requestedMap);
+            drawString(preparing, 320, 190);
+        }
+        finishFrame();
         return;
     }
     else if (currentState == NAME_INPUT) {
@@ -601,44 +1722,42 @@ GLvoid drawScene() {
         sprintf(timeStr, "Your Time: %.2f sec", recordedTime);
         drawString(timeStr, 310, 350);
 
-        drawString("Enter Your Name:", 300, 300);
+        // 이 기록이 들어갈 순위
+        char rankStr[64];
+        sprintf(rankStr, "Rank: #%d of %d", (int)leaderboard.rank(selectedMap, recordedTime),
+            (int)leaderboard.count(selectedMap) + 1);
+        drawString(rankStr, 320, 325);
+
+        drawString("Enter Your Name:", 300, 290);
 
         // 입력된 이름 표시 (커서 포함)
         std::string displayName = currentInputName + "_";
         drawString(displayName.c_str(), 320, 260);
 
+        // 입력 중인 이름의 이전 최고 기록
+        float best;
+        if (!currentInputName.empty() && leaderboard.personalBest(selectedMap, currentInputName, &best)) {
+            char bestStr[64];
+            sprintf(bestStr, "Personal best: %.2f sec", best);
+            drawString(bestStr, 300, 230);
+        }
+
         drawString("Press ENTER to save", 290, 200);
         drawString("Max 10 characters", 300, 170);
 
-        glutSwapBuffers();
+        finishFrame();
         return;
     }
     else if (currentState == RANKING) {
         glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
         drawString("=== RANKINGS ===", 330, 550);
 
-        // Map 1 Rankings
-        drawString("Map 1 - Gentle Curve", 100, 500);
-        int yPos = 460;
-        for (size_t i = 0; i < rankingsMap1.size(); i++) {
-            char rankStr[128];
-            sprintf(rankStr, "%d. %-12s %.2f sec", (int)(i + 1), rankingsMap1[i].name.c_str(), rankingsMap1[i].time);
-            drawString(rankStr, 100, yPos);
-            yPos -= 30;
-        }
-
-        // Map 2 Rankings
-        drawString("Map 2 - Complex Curve", 450, 500);
-        yPos = 460;
-        for (size_t i = 0; i < rankingsMap2.size(); i++) {
-            char rankStr[128];
-            sprintf(rankStr, "%d. %-12s %.2f sec", (int)(i + 1), rankingsMap2[i].name.c_str(), rankingsMap2[i].time);
-            drawString(rankStr, 450, yPos);
-            yPos -= 30;
-        }
+        // Map 1 / Map 2 Rankings
+        drawRankingColumn(1, "Map 1 - Gentle Curve", 100);
+        drawRankingColumn(2, "Map 2 - Complex Curve", 450);
 
         drawString("Press 'ESC' to return to Menu", 270, 50);
-        glutSwapBuffers();
+        finishFrame();
         return;
     }
     else if (currentState == GAMEOVER) {
@@ -651,122 +1770,142 @@ GLvoid drawScene() {
     glUseProgram(shaderProgramID);
 
     // --- [1] 카메라 설정 ---
+    // 렌더링은 직전 틱과 현재 틱 사이를 보간한 자세로 그린다
+    CarState drawn = lerpCar(prevCar, car, renderAlpha);
+
     // 자동차 뒤쪽에서 바라보는 좌표 계산
     float camDist = 10.0f;
     float camHeight = 5.0f;
-    float eyeX = carX - camDist * sinf(carAngle);
-    float eyeZ = carZ - camDist * (-cosf(carAngle)); 
+    float eyeX = drawn.x - camDist * sinf(drawn.angle);
+    float eyeZ = drawn.z - camDist * (-cosf(drawn.angle)); 
 
     float eyeY = camHeight;
-    float targetX = carX;
+    float targetX = drawn.x;
     float targetY = 0.0f;
-    float targetZ = carZ;
-
-    glUniform3f(viewPosLoc, eyeX, eyeY, eyeZ);
+    float targetZ = drawn.z;
 
-    // gluLookAt을 사용해 View Matrix 생성 후 Shader로 전송
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    gluLookAt(eyeX, eyeY, eyeZ, targetX, targetY, targetZ, 0, 1, 0);
+    sceneUniforms.viewPos[0] = eyeX;
+    sceneUniforms.viewPos[1] = eyeY;
+    sceneUniforms.viewPos[2] = eyeZ;
+    sceneUniforms.viewPos[3] = 1.0f;
 
-    float view[16];
-    glGetFloatv(GL_MODELVIEW_MATRIX, view); // 계산된 행렬 가져오기
-    glPopMatrix(); // 스택 복구
-
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view);
-
-    // Projection Matrix
-    float projection[16];
-    makePerspectiveMatrix(projection, 3.141592f / 4.0f, 800.0f / 600.0f, 0.1f, 300.0f);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection);
+    // View / Projection Matrix (CPU 에서 계산, GL 행렬 스택은 쓰지 않음)
+    sceneUniforms.view = Mat4::lookAt(Vec3(eyeX, eyeY, eyeZ), Vec3(targetX, targetY, targetZ), Vec3(0.0f, 1.0f, 0.0f));
+    sceneUniforms.projection = Mat4::perspective(CAMERA_FOV, CAMERA_ASPECT, CAMERA_NEAR, CAMERA_FAR);
 
     // --- [조명 설정] ---
-    int centerIdx = (int)(abs(carZ) / 20.0f);
-    int lightCount = 0;
-    char uniformName[64];
-    for (int i = centerIdx - 1; i <= centerIdx + 2; ++i) {
-        if (lightCount >= 4) break;
-        float lightZ = -(float)i * 20.0f;
-        float lightX = getRoadCenterX(lightZ, selectedMap) - 2.5f + 1.1f;
-        sprintf(uniformName, "pointLights[%d].position", lightCount);
-        glUniform3f(glGetUniformLocation(shaderProgramID, uniformName), lightX, 2.7f, lightZ);
-        sprintf(uniformName, "pointLights[%d].color", lightCount);
-        glUniform3f(glGetUniformLocation(shaderProgramID, uniformName), 1.0f, 0.9f, 0.6f);
-        sprintf(uniformName, "pointLights[%d].constant", lightCount);
-        glUniform1f(glGetUniformLocation(shaderProgramID, uniformName), 1.0f);
-        sprintf(uniformName, "pointLights[%d].linear", lightCount);
-        glUniform1f(glGetUniformLocation(shaderProgramID, uniformName), 0.09f);
-        sprintf(uniformName, "pointLights[%d].quadratic", lightCount);
-        glUniform1f(glGetUniformLocation(shaderProgramID, uniformName), 0.032f);
-        lightCount++;
-    }
+    // 맵의 모든 가로등을 화면 클러스터에 배정
+    buildLightClusters(sceneUniforms.view);
 
-    float model[16];
-    setIdentityMatrix(model, 4);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
+    // 카메라 + 클러스터 설정을 버퍼 업데이트 한 번으로 전송
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SceneUniforms), &sceneUniforms);
+
+    Mat4 model = Mat4::identity();
+    setModelMatrix(model);
 
     // --- [2] 배경 그리기 ---
     glUniform1i(useTextureLoc, 1);
     glUniform1i(isLightSourceLoc, 0);
 
-    glBindVertexArray(bgVAO);
-
-    // 1) 도로 그리기 
-    glBindTexture(GL_TEXTURE_2D, roadTextureID);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCountRoad);
-
-    // 2) 인도 그리기
-    glBindTexture(GL_TEXTURE_2D, dirtTextureID);
-    glDrawArrays(GL_TRIANGLES, vertexCountRoad, vertexCountSidewalk);
-
-    // 2.5) 피니시라인 그리기
-    glUniform1i(useTextureLoc, 0); // 텍스처 사용 안 함
-    glBindVertexArray(finishLineVAO);
-    setIdentityMatrix(model, 4);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
-    glDrawArrays(GL_TRIANGLES, 0, 6); // 6개의 정점 (2개의 삼각형)
+    {
+        PROFILE_SCOPE("Road");
+        PROFILE_GPU_SCOPE("Road");
+        drawRoadChunks();
+
+        // 2.5) 피니시라인 그리기
+        glUniform1i(useTextureLoc, 0); // 텍스처 사용 안 함
+        glBindVertexArray(finishLineVAO);
+        setModelMatrix(model);
+        glDrawElements(GL_TRIANGLES, finishLineIndexCount, GL_UNSIGNED_SHORT, 0); // 2개의 삼각형
+        drawCallCount++;
+    }
 
     // --- [3] 가로등 ---
-    glUniform1i(useTextureLoc, 0);
-    glBindVertexArray(lightVAO);
-    for (float z = 20.0f; z > -500.0f; z -= 20.0f) {
-
-        float cx = getRoadCenterX(z, selectedMap);
-        float angle = getRoadAngle(z, selectedMap);
-        float tx = cx - (ROAD_WIDTH / 2.0f) - 0.5f;
+    {
+        PROFILE_SCOPE("Lamps");
+        PROFILE_GPU_SCOPE("Lamps");
+        glUniform1i(useTextureLoc, 0);
+        glUniform1i(useInstancingLoc, 1); // 인스턴스 버퍼의 모델 행렬 사용
+        glBindVertexArray(lightVAO);
 
         // 기둥
         glUniform1i(isLightSourceLoc, 0);
-        setTranslationMatrix(model, tx, -0.5f, z);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
-        glDrawArrays(GL_TRIANGLES, 0, 72);
+        glDrawElementsInstanced(GL_TRIANGLES, LAMP_POLE_INDEX_COUNT, GL_UNSIGNED_SHORT, 0, LAMP_INSTANCE_COUNT);
+        drawCallCount++;
 
         // 전구
         glUniform1i(isLightSourceLoc, 1);
-        setTranslationMatrix(model, tx, -0.5f, z);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
-        glDrawArrays(GL_TRIANGLES, 72, 36);
+        glDrawElementsInstanced(GL_TRIANGLES, LAMP_BULB_INDEX_COUNT, GL_UNSIGNED_SHORT,
+            (void*)(LAMP_POLE_INDEX_COUNT * sizeof(uint16_t)), LAMP_INSTANCE_COUNT);
+        drawCallCount++;
+
+        glUniform1i(useInstancingLoc, 0);
     }
 
     // --- [4] 자동차 (기존 유지) ---
-    glUniform1i(isLightSourceLoc, 0);
-    float rot[16];
-    setRotationYMatrix(rot, carAngle);
-    rot[12] = carX; rot[13] = -0.25f; rot[14] = carZ;
-    for (int i = 0; i < 16; ++i) model[i] = rot[i];
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
-    glBindVertexArray(carVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 984);
+    {
+        PROFILE_SCOPE("Car");
+        PROFILE_GPU_SCOPE("Car");
+        glUniform1i(isLightSourceLoc, 0);
+        model = Mat4::translation(drawn.x, -0.25f, drawn.z) * Mat4::rotationY(drawn.angle);
+        setModelMatrix(model);
+        glBindVertexArray(carVAO);
+        glDrawElements(GL_TRIANGLES, carIndexCount, GL_UNSIGNED_SHORT, 0);
+        drawCallCount++;
+    }
+
+    // --- [5] 고스트 (반투명, 같은 carVAO 로 인스턴스 하나씩) ---
+    int ghostCount = (currentState == PLAY) ? uploadGhostInstances(renderAlpha) : 0;
+    if (ghostCount > 0) {
+        PROFILE_SCOPE("Ghosts");
+        PROFILE_GPU_SCOPE("Ghosts");
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE); // 고스트끼리 / 플레이어를 가리지 않게
+        glUniform1i(useInstancingLoc, 1);
+        glBindVertexArray(carVAO);
+        glDrawElementsInstanced(GL_TRIANGLES, carIndexCount, GL_UNSIGNED_SHORT, 0, ghostCount);
+        drawCallCount++;
+        glUniform1i(useInstancingLoc, 0);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    // 달리고 있는 고스트와 그 기록
+    if (currentState == PLAY) {
+        int line = 0;
+        for (int i = 0; i < MAX_GHOSTS; ++i) {
+            if (!ghosts[i].active()) continue;
+            char ghostStr[64];
+            sprintf(ghostStr, "Ghost %s: %.2f sec", GHOST_LABELS[i], ghosts[i].recordedTime() / 1000.0f);
+            drawString(ghostStr, 600, 560 - 30 * line++);
+        }
+    }
+
+    if (currentState == PLAY && playbackActive) {
+        char replayStr[64];
+        if (playbackFastForward) sprintf(replayStr, "REPLAY x%d  [F] Normal Speed", REPLAY_FAST_FORWARD);
+        else sprintf(replayStr, "REPLAY  [F] Fast Forward");
+        drawString(replayStr, 20, 500);
+    }
 
     // 타이머 표시
-    if (currentState == PLAY && timerStarted) {
+    if (currentState == PLAY && car.timerStarted) {
         char timeStr[64];
-        float seconds = elapsedTime / 1000.0f;
+        float seconds = car.elapsedTime / 1000.0f;
         sprintf(timeStr, "Time: %.2f sec", seconds);
         drawString(timeStr, 20, 560);
 
-        if (finishReached) {
+        // 진행률 (중심선을 따라 잰 거리 기준)
+        const TrackSampler& track = getTrackSampler(car.mapType);
+        char progressStr[64];
+        sprintf(progressStr, "Progress: %3.0f%% (%.0f / %.0f m)",
+            std::max(0.0f, trackProgress(car)) * 100.0f,
+            std::max(0.0f, track.distanceAlongTrack(car.x, car.z)), track.arcLengthAt(car.finishZ));
+        drawString(progressStr, 20, 530);
+
+        if (car.finishReached) {
             drawString("FINISH!", 350, 300);
             char finalTimeStr[64];
             sprintf(finalTimeStr, "Final Time: %.2f sec", seconds);
@@ -778,26 +1917,61 @@ GLvoid drawScene() {
         drawString("GAME OVER", 350, 300);
         drawString("Press 'R' to Restart", 320, 270);
 
-        if (timerStarted) {
+        if (car.timerStarted) {
             char timeStr[64];
-            float seconds = elapsedTime / 1000.0f;
+            float seconds = car.elapsedTime / 1000.0f;
             sprintf(timeStr, "Time: %.2f sec", seconds);
             drawString(timeStr, 320, 240);
         }
     }
 
-    glutSwapBuffers();
+    finishFrame();
+}
+
+// 다시 그리기 요청 (한 프레임 안의 여러 요청은 하나로 합침)
+void requestRedraw() {
+    if (redrawPending || headlessContext) return;
+    redrawPending = true;
+    glutPostRedisplay();
+}
+
+// 매 프레임 타이머가 필요한가: 게임 중이거나, trace 저장처럼 연속 프레임이 필요할 때
+bool needsTimer() {
+#if ENABLE_PROFILER
+    if (profiler().capturing()) return true;
+#endif
+    return currentState == PLAY || currentState == LOADING || mapSwitchPending();
+}
+
+void Timer(int value);
+
+void startTimer() {
+    if (timerRunning || !needsTimer()) return;
+    timerRunning = true;
+    lastFrameTime = glutGet(GLUT_ELAPSED_TIME); // 멈춰 있던 시간은 시뮬레이션하지 않음
+    glutTimerFunc(renderIntervalMs, Timer, 0);
 }
 
-GLvoid Reshape(int w, int h) { glViewport(0, 0, w, h); }
+// 키 입력 뒤: 화면을 한 번 다시 그리고, PLAY 로 들어갔으면 타이머를 다시 건다
+void onInput() {
+    requestRedraw();
+    startTimer();
+}
+
+GLvoid Reshape(int w, int h) {
+    glViewport(0, 0, w, h);
+    winWidth = std::max(1, w);
+    winHeight = std::max(1, h);
+}
 void Keyboard(unsigned char key, int x, int y) {
     if (key == 'q' || key == 'Q') exit(0);
 
     if (currentState == MENU) {
-        if (key == '1') initGame(1);
-        if (key == '2') initGame(2);
+        if (key == '1') requestMapSwitch(1);
+        if (key == '2') requestMapSwitch(2);
+        if (key == 'g' || key == 'G') ghostsEnabled = !ghostsEnabled;
         if (key == 'r' || key == 'R') {
-            loadRankings();
+            cancelMapSwitch();
             currentState = RANKING;
         }
     }
@@ -805,7 +1979,6 @@ void Keyboard(unsigned char key, int x, int y) {
         if (key == 13) { // ENTER key
             // 이름 저장하고 메뉴로
             saveRanking(selectedMap, recordedTime, currentInputName);
-            loadRankings(); // 랭킹 다시 로드
             currentState = MENU;
         }
         else if (key == 8) { // BACKSPACE key
@@ -829,53 +2002,666 @@ void Keyboard(unsigned char key, int x, int y) {
             currentState = MENU;
         }
     }
+    else if (currentState == PLAY) {
+        if (playbackActive && (key == 'f' || key == 'F')) playbackFastForward = !playbackFastForward;
+    }
+    onInput();
 }
 
-void SpecialKeyboard(int key, int x, int y) { specialKeyStates[key] = true; }
+void SpecialKeyboard(int key, int x, int y) {
+#if ENABLE_PROFILER
+    // F3: 프로파일러 오버레이, F4: 다음 프레임들을 Chrome trace 로 저장
+    if (key == GLUT_KEY_F3) showProfiler = !showProfiler;
+    if (key == GLUT_KEY_F4 && !profiler().capturing()) profiler().captureTrace(PROFILER_TRACE_FRAMES, PROFILER_TRACE_FILE);
+#endif
+    specialKeyStates[key] = true;
+    onInput();
+}
 void SpecialKeyboardUp(int key, int x, int y) { specialKeyStates[key] = false; }
 
+// 고정 틱 시뮬레이션 + 가변 주기 렌더링
+// 실제 경과 시간을 누적해 두고 1 / simHz 초 단위로 잘라서 시뮬레이션한 뒤,
+// 남은 시간 비율(renderAlpha)로 직전/현재 틱 사이를 보간해서 그린다.
 void Timer(int value) {
-    updateCar();
-    glutPostRedisplay();
-    glutTimerFunc(16, Timer, 0);
+    // 정지 화면으로 바뀌었으면 마지막 한 번만 그리고 타이머를 멈춤 (다음 입력 때 다시 시작)
+    if (!needsTimer()) {
+        timerRunning = false;
+        requestRedraw();
+        return;
+    }
+
+    int now = glutGet(GLUT_ELAPSED_TIME);
+    int speed = (playbackActive && playbackFastForward) ? REPLAY_FAST_FORWARD : 1;
+    simAccumulator += (float)(now - lastFrameTime) * speed;
+    lastFrameTime = now;
+
+    float stepMs = 1000.0f / simHz;
+    int substeps = 0;
+    {
+        PROFILE_SCOPE("Simulation");
+        while (simAccumulator >= stepMs && substeps < MAX_SUBSTEPS * speed) {
+            updateCar();
+            simAccumulator -= stepMs;
+            substeps++;
+        }
+    }
+    // 따라잡지 못한 시간은 버린다 (느린 기기에서 틱이 계속 밀리는 것 방지)
+    if (simAccumulator >= stepMs) simAccumulator = fmodf(simAccumulator, stepMs);
+    renderAlpha = (currentState == PLAY) ? simAccumulator / stepMs : 1.0f;
+
+    if (currentState == PLAY) updateRoadStreaming(car.z);
+    if (currentState == LOADING) updateAssetLoading();
+    if (mapSwitchPending()) updateMapSwitch();
+
+    requestRedraw();
+    glutTimerFunc(renderIntervalMs, Timer, 0);
+}
+
+// --- 헤드리스 시뮬레이션 모드 ---
+// 창/GL 컨텍스트 없이 입력 스크립트대로 시뮬레이션만 최대 속도로 돌린다.
+// 스크립트 형식: 한 줄에 "<틱 수> <키>" (키는 U/D/L/R 조합, 입력 없음은 '-'), '#' 은 주석
+struct ScriptStep {
+    int ticks;
+    CarInput input;
+};
+
+bool loadInputScript(const char* filename, std::vector<ScriptStep>& steps) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        ScriptStep step;
+        std::string keys;
+        if (!(iss >> step.ticks)) continue;
+        iss >> keys;
+        for (char c : keys) {
+            if (c == 'U' || c == 'u') step.input.up = true;
+            if (c == 'D' || c == 'd') step.input.down = true;
+            if (c == 'L' || c == 'l') step.input.left = true;
+            if (c == 'R' || c == 'r') step.input.right = true;
+        }
+        steps.push_back(step);
+    }
+    return true;
+}
+
+// 스크립트 한 번 실행. 결과와 진행한 틱 수를 돌려준다.
+StepResult runScript(const std::vector<ScriptStep>& steps, int mapType, CarState& state, long long& ticks) {
+    resetCar(state, mapType, trackLength);
+    ticks = 0;
+    for (const auto& step : steps) {
+        for (int i = 0; i < step.ticks; ++i) {
+            StepResult result = stepCar(state, step.input, 1.0f / simHz);
+            ++ticks;
+            if (result != STEP_RUNNING) return result;
+        }
+    }
+    return STEP_RUNNING;
+}
+
+// 사용법: termproject [--sim-hz N] --headless <맵 번호> <스크립트 파일> [반복 횟수]
+// 스크립트의 틱 수는 시뮬레이션 틱(1 / simHz 초) 기준
+int runHeadless(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " --headless <map> <script> [repeat]" << std::endl;
+        return 1;
+    }
+    int mapType = atoi(argv[2]);
+    int repeat = (argc >= 5) ? atoi(argv[4]) : 1;
+    if (mapType != 1 && mapType != 2) { std::cerr << "Unknown map: " << argv[2] << std::endl; return 1; }
+    if (repeat < 1) repeat = 1;
+
+    std::vector<ScriptStep> steps;
+    if (!loadInputScript(argv[3], steps)) { std::cerr << "Script not found: " << argv[3] << std::endl; return 1; }
+
+    CarState state;
+    StepResult result = STEP_RUNNING;
+    long long ticks = 0, totalTicks = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        result = runScript(steps, mapType, state, ticks);
+        totalTicks += ticks;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - begin).count();
+
+    const char* resultStr = (result == STEP_FINISHED) ? "FINISH" : (result == STEP_CRASHED) ? "CRASH" : "INCOMPLETE";
+    printf("result=%s map=%d ticks=%lld time=%.3f x=%.3f z=%.3f\n",
+        resultStr, mapType, ticks, state.elapsedTime / 1000.0f, state.x, state.z);
+    printf("runs=%d sim_hz=%d total_ticks=%lld wall=%.3fs ticks_per_sec=%.0f\n",
+        repeat, simHz, totalTicks, seconds, seconds > 0.0 ? totalTicks / seconds : 0.0);
+    return (result == STEP_CRASHED) ? 2 : 0;
+}
+
+// 리플레이 파일을 불러와 이 빌드에서 재생할 수 있는지 확인
+bool loadReplayFile(const char* path, Replay& replay) {
+    std::string error;
+    if (!replay.load(path, &error)) {
+        std::cerr << "Replay " << path << ": " << error << std::endl;
+        return false;
+    }
+    if (!replay.compatible()) {
+        std::cerr << "Replay " << path << ": recorded with different simulation rules" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 사용법: termproject --headless-replay <리플레이 파일> [반복 횟수]
+// 화면 없이 빨리 감기로 끝까지 재생하고, 결과가 녹화 당시와 같은지 출력 (다르면 종료 코드 3)
+int runHeadlessReplay(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " --headless-replay <replay> [repeat]" << std::endl;
+        return 1;
+    }
+    int repeat = (argc >= 4) ? std::max(1, atoi(argv[3])) : 1;
+    Replay replay;
+    if (!loadReplayFile(argv[2], replay)) return 1;
+    prepareTrackSamplers(replay.header.trackLength);
+
+    ReplayOutcome outcome;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) outcome = simulateReplay(replay);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const ReplayHeader& h = replay.header;
+    bool match = outcome.result == (StepResult)h.result && outcome.elapsedMs == h.elapsedMs && outcome.ticks == (long long)h.ticks;
+    printf("result=%s map=%d ticks=%lld time=%.3f recorded=%s/%.3f match=%s\n",
+        stepResultName(outcome.result), h.mapType, outcome.ticks, outcome.elapsedMs / 1000.0f,
+        stepResultName((StepResult)h.result), h.elapsedMs / 1000.0f, match ? "yes" : "no");
+    printf("runs=%d sim_hz=%d bytes=%u wall=%.3fs ms_per_run=%.3f\n",
+        repeat, h.simHz, h.dataBytes, seconds, seconds * 1000.0 / repeat);
+    return match ? 0 : 3;
+}
+
+// 검증할 기록 하나 (랭킹 기록이면 seq / 이름이 있음)
+struct VerifyJob {
+    std::string path;
+    uint64_t seq = 0;
+    std::string name;
+    int mapType = 0;
+    int claimedMs = 0;
+
+    bool missing = false;       // 리플레이 파일 없음
+    bool accepted = false;
+    std::string reason;
+    ReplayOutcome outcome = ReplayOutcome();
+};
+
+void verifyJob(VerifyJob& job, bool claimFromHeader) {
+    Replay replay;
+    std::string error;
+    if (!replay.load(job.path, &error)) {
+        job.missing = (error == "cannot open");
+        job.reason = error;
+        return;
+    }
+    if (claimFromHeader) {
+        job.mapType = replay.header.mapType;
+        job.claimedMs = replay.header.elapsedMs;
+    }
+    ReplayVerification v = verifyReplay(replay, job.mapType, job.claimedMs);
+    job.accepted = v.accepted;
+    job.outcome = v.outcome;
+    if (v.reason) job.reason = v.reason;
+}
+
+// 사용법: termproject --verify [--threads 작업 스레드 수] [리플레이 파일 ...]
+// 파일을 주지 않으면 랭킹의 모든 완주 기록을 replays/<seq>.rpl 로 다시 달려 확인하고,
+// 파일을 주면 각 리플레이 헤더에 적힌 기록을 확인한다. 기록마다 한 작업으로 모든 코어에 나눠 처리.
+// 예전 rankings.txt 에서 가져온 기록(저장 시각 0)은 리플레이가 없으므로 건너뛰고 개수만 출력.
+// 통과하지 못한 기록만 한 줄씩 출력. 리플레이 없는 기록(NO REPLAY)은 보고만 하고, 거부된 기록이 있을 때만 종료 코드 3.
+int runVerify(int argc, char** argv) {
+    int threads = 0;
+    std::vector<VerifyJob> jobs;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            continue;
+        }
+        VerifyJob job;
+        job.path = argv[i];
+        jobs.push_back(job);
+    }
+    bool claimFromHeader = !jobs.empty();
+    int legacy = 0;
+    if (!claimFromHeader) {
+        RankingJournal journal("rankings");
+        journal.load(0, [&](const RankingRecord& r) {
+            // 예전 rankings.txt 에서 가져온 기록은 리플레이가 생기기 전의 것이라 검증 대상이 아님
+            if (r.timestamp == 0) {
+                legacy++;
+                return;
+            }
+            VerifyJob job;
+            job.path = replayPathForSeq(r.seq);
+            job.seq = r.seq;
+            job.name = r.entry.name;
+            job.mapType = r.entry.mapType;
+            job.claimedMs = (int)lroundf(r.entry.time * 1000.0f); // 기록은 elapsedTime / 1000
+            jobs.push_back(job);
+        });
+    }
+    if (jobs.empty()) {
+        printf("Nothing to verify (legacy=%d)\n", legacy);
+        return 0;
+    }
+
+    // 리플레이 길이가 제각각이라 덩어리를 고정하지 않고 스레드마다 다음 작업을 하나씩 가져감
+    ThreadPool pool(threads);
+    std::atomic<size_t> nextJob(0);
+    auto begin = std::chrono::steady_clock::now();
+    pool.parallelFor(pool.size() + 1, [&](int, int) {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) verifyJob(jobs[i], claimFromHeader);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int accepted = 0, rejected = 0, missing = 0;
+    long long ticks = 0;
+    for (const VerifyJob& job : jobs) {
+        ticks += job.outcome.ticks;
+        if (job.accepted) { accepted++; continue; }
+        if (job.missing) missing++;
+        else rejected++;
+
+        char label[96];
+        if (claimFromHeader) snprintf(label, sizeof(label), "%s", job.path.c_str());
+        else snprintf(label, sizeof(label), "#%llu %s", (unsigned long long)job.seq, job.name.c_str());
+        if (job.missing) {
+            printf("%s map %d %.2f sec: NO REPLAY\n", label, job.mapType, job.claimedMs / 1000.0f);
+        }
+        else if (job.outcome.ticks > 0) {
+            printf("%s map %d %.2f sec: REJECT %s (replay %s %.2f sec)\n", label, job.mapType, job.claimedMs / 1000.0f,
+                job.reason.c_str(), stepResultName(job.outcome.result), job.outcome.elapsedMs / 1000.0f);
+        }
+        else {
+            printf("%s map %d %.2f sec: REJECT %s\n", label, job.mapType, job.claimedMs / 1000.0f, job.reason.c_str());
+        }
+    }
+    printf("verified=%d accepted=%d rejected=%d no_replay=%d legacy=%d threads=%d wall=%.3fs replays_per_sec=%.0f ticks_per_sec=%.0f\n",
+        (int)jobs.size(), accepted, rejected, missing, legacy, pool.size() + 1, seconds,
+        jobs.size() / std::max(seconds, 1e-9), ticks / std::max(seconds, 1e-9));
+    // 리플레이가 없는 기록은 따로 보고만 하고, 실패(3)는 리플레이가 기록과 맞지 않을 때만
+    return (rejected == 0) ? 0 : 3;
+}
+
+// 사용법: termproject [--sim-hz N] [--track-length L] --batch-sim <맵 번호> [자동차 수] [틱 수] [작업 스레드 수]
+// BatchEnv 로 자동차 여러 대를 한꺼번에 달리게 해서 처리량을 잰다. 행동은 관측만 보는 단순한 조향
+// (중심선 쪽으로 방향을 맞추고 방향이 맞을 때만 전진), 끝난 차는 바로 다시 출발.
+// 기본 틱 수는 두 맵 모두 한 바퀴 이상 완주하는 길이 (map 2 는 60 Hz 에서 2100 틱 이상 걸림)
+const int BATCH_SIM_DEFAULT_CARS = 65536;
+const int BATCH_SIM_DEFAULT_TICKS = 4000;
+
+int runBatchSim(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " --batch-sim <map> [cars] [ticks] [threads]" << std::endl;
+        return 1;
+    }
+    int mapType = atoi(argv[2]);
+    int cars = (argc >= 4) ? atoi(argv[3]) : BATCH_SIM_DEFAULT_CARS;
+    int ticks = (argc >= 5) ? atoi(argv[4]) : BATCH_SIM_DEFAULT_TICKS;
+    int threads = (argc >= 6) ? atoi(argv[5]) : 0;
+    if (mapType != 1 && mapType != 2) { std::cerr << "Unknown map: " << argv[2] << std::endl; return 1; }
+    if (cars < 1) cars = BATCH_SIM_DEFAULT_CARS;
+    if (ticks < 1) ticks = BATCH_SIM_DEFAULT_TICKS;
+
+    BatchEnv env(mapType, cars, trackLength, simHz);
+    ThreadPool pool(threads);
+    std::vector<uint8_t> actions(cars);
+    long long finished = 0, crashed = 0;
+    double policySeconds = 0.0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        auto p0 = std::chrono::steady_clock::now();
+        const float* offset = env.centerOffsets();
+        const float* heading = env.headingErrors();
+        for (int i = 0; i < cars; ++i) {
+            // autopilotInput 과 같은 규칙: 방향 오차가 작을 때만 가속 (항상 가속하면 첫 굽은 길에서 모두 충돌)
+            float error = -0.8f * offset[i] - heading[i]; // + 면 오른쪽으로 돌아야 함
+            actions[i] = (uint8_t)((fabsf(error) < AUTOPILOT_THROTTLE_TOLERANCE ? REPLAY_KEY_UP : 0)
+                | (error > AUTOPILOT_STEER_DEADZONE ? REPLAY_KEY_RIGHT : 0)
+                | (error < -AUTOPILOT_STEER_DEADZONE ? REPLAY_KEY_LEFT : 0));
+        }
+        policySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - p0).count();
+
+        env.step(actions.data(), &pool);
+        const uint8_t* done = env.done();
+        for (int i = 0; i < cars; ++i) {
+            if (!done[i]) continue;
+            if (env.result(i) == STEP_FINISHED) finished++;
+            else crashed++;
+        }
+        env.resetDone();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    double simSeconds = std::max(seconds - policySeconds, 1e-9);
+    long long carSteps = (long long)cars * ticks;
+
+    printf("map=%d cars=%d ticks=%d threads=%d simd=%s\n", mapType, cars, ticks, pool.size() + 1,
+        BATCH_ENV_SSE2 ? "sse2" : "none");
+    printf("finished=%lld crashed=%lld wall=%.3fs env=%.3fs car_steps_per_sec=%.1fM (env only %.1fM)\n",
+        finished, crashed, seconds, simSeconds, carSteps / seconds / 1e6, carSteps / simSeconds / 1e6);
+    return 0;
+}
+
+// --- 벤치마크 모드 ---
+// 입력 스크립트(또는 자동 운전)로 정해진 프레임 수만큼 오프스크린(FBO)에 그리고 통계를 JSON 으로 출력한다.
+// 프레임 사이 시간은 벽시계가 아니라 1 / fps 초로 고정하므로 기기가 느려도 같은 장면을 그린다.
+// 리눅스에서는 창 없이 EGL 컨텍스트를 만들어 실행하므로 X 서버가 필요 없다. GPU 가 없으면 Mesa 소프트웨어 래스터라이저:
+//   make && LIBGL_ALWAYS_SOFTWARE=1 ./termproject --benchmark 1 bench_map1.txt 600
+// bench_map1.txt / bench_map2.txt 는 60 Hz 에서 녹화한 입력 스크립트 (다른 --sim-hz 에서는 자동 운전 auto 를 쓸 것)
+const int BENCH_WARMUP_FRAMES = 30;   // 통계에서 제외하는 처음 프레임 (청크 생성, 셰이더 준비)
+const int BENCH_DEFAULT_FRAMES = 600;
+const int BENCH_WIDTH = 800;          // 오프스크린 해상도 (기본 창 크기와 같음)
+const int BENCH_HEIGHT = 600;
+
+// 스크립트 입력을 틱마다 하나씩 꺼내 줌. 스크립트가 없으면 자동 운전.
+struct BenchInput {
+    std::vector<ScriptStep> steps;
+    size_t stepIndex = 0;
+    int tickInStep = 0;
+
+    bool autopilot() const { return steps.empty(); }
+
+    CarInput next(const CarState& state) {
+        if (autopilot()) return autopilotInput(state);
+        while (stepIndex < steps.size() && tickInStep >= steps[stepIndex].ticks) {
+            stepIndex++;
+            tickInStep = 0;
+        }
+        if (stepIndex >= steps.size()) return CarInput(); // 스크립트가 끝나면 입력 없음
+        tickInStep++;
+        return steps[stepIndex].input;
+    }
+
+    void rewind() { stepIndex = 0; tickInStep = 0; }
+};
+
+// 정렬된 값에서 백분위수 (최근접 순위)
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+    if (rank < 1) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+// JSON 문자열 출력 (따옴표, 역슬래시, 제어 문자 이스케이프)
+void printJsonString(const char* str) {
+    putchar('"');
+    for (const char* c = str; *c; ++c) {
+        if (*c == '"' || *c == '\\') printf("\\%c", *c);
+        else if ((unsigned char)*c < 0x20) printf("\\u%04x", *c);
+        else putchar(*c);
+    }
+    putchar('"');
+}
+
+double mean(const std::vector<double>& values) {
+    if (values.empty()) return 0.0;
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    return sum / values.size();
+}
+
+// 사용법: termproject [--sim-hz N] [--fps N] [--track-length L] --benchmark <맵 번호> <스크립트 파일 | auto> [프레임 수]
+// GL 초기화가 끝난 뒤 main 에서 호출됨. 결과 JSON 은 stdout, 진행 메시지는 stderr.
+int runBenchmark(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " --benchmark <map> <script|auto> [frames]" << std::endl;
+        return 1;
+    }
+    int mapType = atoi(argv[2]);
+    const char* scriptName = argv[3];
+    int frames = (argc >= 5) ? atoi(argv[4]) : BENCH_DEFAULT_FRAMES;
+    if (mapType != 1 && mapType != 2) { std::cerr << "Unknown map: " << argv[2] << std::endl; return 1; }
+    if (frames < 1) frames = BENCH_DEFAULT_FRAMES;
+
+    BenchInput input;
+    if (strcmp(scriptName, "auto") != 0 && !loadInputScript(scriptName, input.steps)) {
+        std::cerr << "Script not found: " << scriptName << std::endl;
+        return 1;
+    }
+
+    // 오프스크린 렌더 타깃 (창 크기와 무관하게 800x600)
+    GLuint fbo, colorRbo, depthRbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &colorRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRbo);
+    glGenRenderbuffers(1, &depthRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, BENCH_WIDTH, BENCH_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRbo);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Benchmark: offscreen framebuffer incomplete" << std::endl;
+        return 1;
+    }
+    Reshape(BENCH_WIDTH, BENCH_HEIGHT);
+
+    initGame(mapType);
+    float stepMs = 1000.0f / simHz;
+    int restarts = 0;
+
+    std::vector<double> frameMs, simMs, drawMs, drawCalls;
+    frameMs.reserve(frames);
+    simMs.reserve(frames);
+    drawMs.reserve(frames);
+    drawCalls.reserve(frames);
+
+    fprintf(stderr, "Benchmark: map %d, %s, track %.0f, %d frames (+%d warmup) on %s\n",
+        mapType, input.autopilot() ? "autopilot" : scriptName, trackLength, frames, BENCH_WARMUP_FRAMES,
+        (const char*)glGetString(GL_RENDERER));
+
+    for (int f = 0; f < BENCH_WARMUP_FRAMES + frames; ++f) {
+#if ENABLE_PROFILER
+        if (f == BENCH_WARMUP_FRAMES) profiler().resetTotals();
+#endif
+        auto t0 = std::chrono::steady_clock::now();
+
+        // 1) 시뮬레이션: 프레임 하나(1 / fps 초)만큼 틱 진행. 끝나거나 충돌하면 처음부터 다시.
+        {
+            PROFILE_SCOPE("Simulation");
+            simAccumulator += (float)renderIntervalMs;
+            while (simAccumulator >= stepMs) {
+                CarInput in = input.next(car);
+                specialKeyStates[GLUT_KEY_UP] = in.up;
+                specialKeyStates[GLUT_KEY_DOWN] = in.down;
+                specialKeyStates[GLUT_KEY_LEFT] = in.left;
+                specialKeyStates[GLUT_KEY_RIGHT] = in.right;
+                updateCar();
+                simAccumulator -= stepMs;
+                if (currentState != PLAY) {
+                    initGame(mapType);
+                    input.rewind();
+                    restarts++;
+                }
+            }
+            renderAlpha = simAccumulator / stepMs;
+            updateRoadStreaming(car.z);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        // 2) 그리기 (glFinish 로 GPU/소프트웨어 래스터라이저 작업까지 포함)
+        drawCallCount = 0;
+        drawScene();
+        glFinish();
+        auto t2 = std::chrono::steady_clock::now();
+
+        if (f < BENCH_WARMUP_FRAMES) continue;
+        frameMs.push_back(std::chrono::duration<double, std::milli>(t2 - t0).count());
+        simMs.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        drawMs.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+        drawCalls.push_back(drawCallCount);
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double maxDrawCalls = *std::max_element(drawCalls.begin(), drawCalls.end());
+
+    printf("{\n");
+    printf("  \"map\": %d,\n", mapType);
+    printf("  \"input\": ");
+    printJsonString(input.autopilot() ? "auto" : scriptName);
+    printf(",\n");
+    printf("  \"track_length\": %.1f,\n", trackLength);
+    printf("  \"frames\": %d,\n", frames);
+    printf("  \"sim_hz\": %d,\n", simHz);
+    printf("  \"frame_interval_ms\": %d,\n", renderIntervalMs);
+    printf("  \"restarts\": %d,\n", restarts);
+    printf("  \"renderer\": ");
+    printJsonString((const char*)glGetString(GL_RENDERER));
+    printf(",\n");
+    printf("  \"frame_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+        mean(frameMs), percentile(sorted, 50), percentile(sorted, 95), percentile(sorted, 99), sorted.back());
+    printf("  \"cpu_ms\": { \"update_car\": %.4f, \"draw_scene\": %.4f",
+        mean(simMs), mean(drawMs));
+#if ENABLE_PROFILER
+    // 프로파일러 스코프별 프레임당 평균 (CPU / GPU)
+    profiler().forEachStat([&](const Profiler::Stat& st) {
+        printf(", \"%s\": %.4f", st.name, st.totalCpuMs / frames);
+    });
+    printf(" },\n");
+    printf("  \"gpu_ms\": {");
+    bool first = true;
+    profiler().forEachStat([&](const Profiler::Stat& st) {
+        if (st.gpuSamples == 0) return;
+        printf("%s \"%s\": %.4f", first ? "" : ",", st.name, st.totalGpuMs / st.gpuSamples);
+        first = false;
+    });
+#endif
+    printf(" },\n");
+    printf("  \"draw_calls\": { \"mean\": %.2f, \"max\": %.0f }\n", mean(drawCalls), maxDrawCalls);
+    printf("}\n");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &colorRbo);
+    glDeleteRenderbuffers(1, &depthRbo);
+    glDeleteFramebuffers(1, &fbo);
+    return 0;
+}
+
+// 루프 설정 옵션(--sim-hz N, --fps N, --track-length L)을 읽고 argv 에서 제거
+void parseLoopOptions(int& argc, char** argv) {
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--sim-hz") == 0 && i + 1 < argc) {
+            int hz = atoi(argv[++i]);
+            if (hz > 0) simHz = hz;
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            int fps = atoi(argv[++i]);
+            if (fps > 0) renderIntervalMs = std::max(1, 1000 / fps);
+        }
+        else if (strcmp(argv[i], "--track-length") == 0 && i + 1 < argc) {
+            float length = (float)atof(argv[++i]);
+            if (length > FINISH_LINE_MARGIN) trackLength = length;
+        }
+        else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
 }
 
 int main(int argc, char** argv) {
-    glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
-    glutInitWindowPosition(100, 100);
-    glutInitWindowSize(800, 600);
-    glutCreateWindow("Curved Road Racing");
+    parseLoopOptions(argc, argv);
+
+    // 트랙 표는 작업 스레드가 돌기 전에 여기서 한 번만 만든다 (검증은 기본 길이 기준이라 그 이상으로)
+    prepareTrackSamplers(std::max(trackLength, DEFAULT_TRACK_LENGTH));
+
+    // 헤드리스 모드는 GLUT 초기화 전에 분기 (창/GL 컨텍스트 생성 안 함)
+    if (argc >= 2 && strcmp(argv[1], "--headless") == 0) {
+        return runHeadless(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--headless-replay") == 0) {
+        return runHeadlessReplay(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--verify") == 0) {
+        return runVerify(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--batch-sim") == 0) {
+        return runBatchSim(argc, argv);
+    }
+
+    // 창에서 리플레이 재생: 녹화 당시의 틱 주기 / 도로 길이로 맞추고, 에셋 로딩이 끝나면 그 맵으로 시작
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0) {
+        if (!loadReplayFile(argv[2], playbackReplay)) return 1;
+        simHz = playbackReplay.header.simHz;
+        trackLength = playbackReplay.header.trackLength;
+        prepareTrackSamplers(trackLength);
+        playbackPending = true;
+    }
+
+    bool benchmark = (argc >= 2 && strcmp(argv[1], "--benchmark") == 0);
+
+    // 벤치마크는 FBO 에만 그리므로 리눅스에서는 창(X 서버) 없이 EGL 컨텍스트를 만든다
+    headlessContext = benchmark && HEADLESS_GL_SUPPORTED;
+    if (headlessContext) {
+        std::string error;
+        if (!createHeadlessGLContext(&error)) {
+            std::cerr << "Benchmark: " << error << std::endl;
+            return 1;
+        }
+    }
+    else {
+        glutInit(&argc, argv);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+        glutInitWindowPosition(100, 100);
+        glutInitWindowSize(800, 600);
+        glutCreateWindow("Curved Road Racing");
+        if (benchmark) glutHideWindow(); // 벤치마크는 FBO 에만 그림
+    }
 
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) exit(EXIT_FAILURE);
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLX 용으로 빌드한 GLEW 는 EGL 컨텍스트에서 GL 함수를 다 읽은 뒤 GLX 디스플레이만 없다고 이 값을 돌려준다
+    if (headlessContext && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK) exit(EXIT_FAILURE);
     glEnable(GL_DEPTH_TEST);
 
     // 랭킹 로드
     loadRankings();
 
-    make_Shaders();
+    workerPool = new ThreadPool();
 
-    modelLoc = glGetUniformLocation(shaderProgramID, "model");
-    viewLoc = glGetUniformLocation(shaderProgramID, "view");
-    projLoc = glGetUniformLocation(shaderProgramID, "projection");
-    useTextureLoc = glGetUniformLocation(shaderProgramID, "useTexture");
-    isLightSourceLoc = glGetUniformLocation(shaderProgramID, "isLightSource");
-    viewPosLoc = glGetUniformLocation(shaderProgramID, "viewPos");
-
-    roadTextureID = LoadTexture("road.png"); 
-    dirtTextureID = LoadTexture("dirt.png"); 
+    // 로딩 화면에 필요한 텍스트 렌더러만 먼저 만들고, 나머지 에셋은 작업 스레드에서 준비
+    textProgramID = make_Program("text_vertex.glsl", "text_fragment.glsl");
+    initTextRenderer();
+    startAssetLoading();
 
     // 기본 버퍼 초기화 (메뉴 화면용 더미 데이터 혹은 초기값)
-    initCubeObj(&lightVAO, &lightVBO, false);
-    initCubeObj(&carVAO, &carVBO, true);
+    initCubeObj(&lightVAO, &lightVBO, &lightEBO, false);
+    carIndexCount = initCubeObj(&carVAO, &carVBO, &carEBO, true);
+    initGhostRendering();
+    initClusterLighting();
+    initRoadStreaming();
+    initMapSwitching();
+
+    if (benchmark) {
+        ghostsEnabled = false; // 측정 조건을 기록 파일과 무관하게
+        finishAssetLoading();
+        return runBenchmark(argc, argv);
+    }
 
     glutDisplayFunc(drawScene);
     glutReshapeFunc(Reshape);
     glutKeyboardFunc(Keyboard);
     glutSpecialFunc(SpecialKeyboard);
     glutSpecialUpFunc(SpecialKeyboardUp);
-    glutTimerFunc(16, Timer, 0);
+#if ENABLE_PROFILER
+    atexit(printFrameReport);
+#endif
+    requestRedraw();
+    startTimer(); // 로딩 화면은 타이머로 업로드를 진행
 
     glutMainLoop();
     return 0;
@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 TexCoord;
+in vec4 Color;
+
+out vec4 out_Color;
+
+uniform sampler2D glyphAtlas; // 1ä ۸ Ʋ ( κи 1)
+
+void main()
+{
+    float coverage = texture(glyphAtlas, TexCoord).r;
+    if (coverage < 0.5) discard;
+    out_Color = vec4(Color.rgb, Color.a * coverage);
+}
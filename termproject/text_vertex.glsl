@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location = 0) in vec2 vPos;       // ȭ ǥ (px,  Ʒ )
+layout (location = 1) in vec2 vTexCoord;  // ۸ Ʋ ǥ
+layout (location = 2) in vec4 vColor;     //  
+
+out vec2 TexCoord;
+out vec4 Color;
+
+uniform vec2 screenSize; // ؽƮ ǥ ũ (800 x 600)
+
+void main()
+{
+    TexCoord = vTexCoord;
+    Color = vColor;
+    gl_Position = vec4(vPos / screenSize * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+// --- 작업 스레드 풀 ---
+// 시작할 때 한 번 만든 작업 스레드에 일을 나눠준다. (매 프레임 스레드를 만들지 않음)
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount = 0) {
+        if (threadCount <= 0) {
+            threadCount = (int)std::thread::hardware_concurrency();
+            if (threadCount <= 0) threadCount = 4;
+        }
+        for (int i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers.size(); }
+
+    // 작업 하나를 큐에 넣는다 (완료를 기다리지 않음)
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wakeUp.notify_one();
+    }
+
+    // [0, count) 를 작업 스레드 수만큼 나눠 fn(begin, end) 를 실행하고 모두 끝날 때까지 기다린다.
+    // 호출한 스레드도 한 덩어리를 직접 처리한다.
+    void parallelFor(int count, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        int chunks = std::min(count, size() + 1);
+        int per = (count + chunks - 1) / chunks;
+
+        // 남은 수는 doneMutex 를 잡고서만 바꾼다. (잠그기 전에 줄이면 호출자가 먼저 0 을 보고 반환해
+        // 스택의 mutex / condvar 가 사라진 뒤에 작업 스레드가 잠그거나 notify 할 수 있음)
+        int remaining = chunks - 1;
+        std::mutex doneMutex;
+        std::condition_variable done;
+
+        for (int c = 1; c < chunks; ++c) {
+            int begin = c * per;
+            int end = std::min(count, begin + per);
+            submit([&, begin, end]() {
+                if (begin < end) fn(begin, end);
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (--remaining == 0) done.notify_one();
+            });
+        }
+        fn(0, std::min(count, per));
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&]() { return remaining == 0; });
+    }
+
+private:
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+};
@@ -0,0 +1,185 @@
+﻿#pragma once
+// --- 트랙 곡선 ---
+// 맵마다 도로 중심선 X(z) 를 컴파일 타임에 정해지는 함수 객체 TrackCurve<맵> 으로 둔다.
+// 레이스 중에는 맵이 바뀌지 않으므로 맵 분기는 배치 호출 바깥에서 한 번만 하고, 안쪽 루프는 맵별로 따로 컴파일된다.
+//
+// sin / cos 는 라이브러리 sinf / cosf 대신 다항식 근사 (Cephes sinf / cosf 와 같은 방식):
+//   x 를 pi/4 단위로 접어 |r| <= pi/4 로 줄인 뒤 (pi/4 를 세 부분으로 나눠 빼서 오차를 줄임) 3 차 / 4 차 다항식.
+//   |x| < 8192 에서 절대 오차 < 1e-7 (측정 7.6e-8, 트랙에서 쓰는 인자는 |x| < 100), 중심선 X 로는 libm 과 2e-6 이내
+// 스칼라와 SSE2 경로가 같은 float 연산을 같은 순서로 하므로 결과가 비트 단위로 같고, 플랫폼 libm 과도 무관하다.
+// (트랙 표 -> 충돌 판정에 들어가므로 리플레이가 어느 빌드에서나 같게 재현됨)
+// 단, 곱셈 + 덧셈이 FMA 로 합쳐지지 않아야 한다: vcxproj 는 /fp:precise (/fp:contract 없음), gcc / clang 은 -ffp-contract=off.
+// (-march=haswell 처럼 FMA 가 있는 대상에서 이 플래그 없이 빌드하면 스칼라 / SSE2 결과가 드물게 1 ulp 다름)
+//
+// 배치 함수 trackCenterXBatch 는 한 번에 16 개 (SSE 레지스터 4 개) 씩 계산하고, 남은 것은 4 개 / 1 개씩 처리한다.
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRACK_CURVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define TRACK_CURVE_SSE2 0
+#endif
+
+namespace trig {
+
+const float FOUR_OVER_PI = 1.27323954473516f;
+const float DP1 = 0.78515625f;                   // pi/4 = DP1 + DP2 + DP3
+const float DP2 = 2.4187564849853515625e-4f;
+const float DP3 = 3.77489497744594108e-8f;
+const float SIN_P0 = -1.9515295891e-4f;
+const float SIN_P1 = 8.3321608736e-3f;
+const float SIN_P2 = -1.6666654611e-1f;
+const float COS_P0 = 2.443315711809948e-5f;
+const float COS_P1 = -1.388731625493765e-3f;
+const float COS_P2 = 4.166664568298827e-2f;
+
+inline uint32_t bits(float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; }
+inline float fromBits(uint32_t u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+// |r| <= pi/4 에서의 두 다항식 (z = r * r)
+inline float sinPoly(float r, float z) {
+    float y = SIN_P0;
+    y = y * z + SIN_P1;
+    y = y * z + SIN_P2;
+    y = y * z;
+    y = y * r;
+    return y + r;
+}
+
+inline float cosPoly(float z) {
+    float y = COS_P0;
+    y = y * z + COS_P1;
+    y = y * z + COS_P2;
+    y = y * z;
+    y = y * z;
+    y = y - z * 0.5f;
+    return y + 1.0f;
+}
+
+// |x| 를 접은 나머지와 접은 횟수 (짝수로 올림)
+inline float reduce(float ax, int& j) {
+    j = (int)(ax * FOUR_OVER_PI);
+    j = (j + 1) & ~1;
+    float y = (float)j;
+    return ((ax - y * DP1) - y * DP2) - y * DP3;
+}
+
+inline float sin(float x) {
+    uint32_t sign = bits(x) & 0x80000000u;
+    int j;
+    float r = reduce(fabsf(x), j);
+    sign ^= (uint32_t)(j & 4) << 29;
+    float z = r * r;
+    float y = (j & 2) ? cosPoly(z) : sinPoly(r, z);
+    return fromBits(bits(y) ^ sign);
+}
+
+inline float cos(float x) {
+    int j;
+    float r = reduce(fabsf(x), j);
+    j -= 2;
+    uint32_t sign = (uint32_t)(~j & 4) << 29;
+    float z = r * r;
+    float y = (j & 2) ? cosPoly(z) : sinPoly(r, z);
+    return fromBits(bits(y) ^ sign);
+}
+
+#if TRACK_CURVE_SSE2
+// 위와 같은 계산을 4 개씩
+inline __m128 polySelect(__m128 r, __m128i j) {
+    __m128 z = _mm_mul_ps(r, r);
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), z), _mm_set1_ps(SIN_P1));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_P2));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), z), _mm_set1_ps(COS_P1));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_P2));
+    c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+    __m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+    return _mm_or_ps(_mm_and_ps(useCos, c), _mm_andnot_ps(useCos, s));
+}
+
+inline __m128 reduce(__m128 ax, __m128i& j) {
+    j = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(FOUR_OVER_PI)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+    __m128 r = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+    return _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+}
+
+inline __m128 sin(__m128 x) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u));
+    __m128 sign = _mm_and_ps(x, signMask);
+    __m128i j;
+    __m128 r = reduce(_mm_andnot_ps(signMask, x), j);
+    sign = _mm_xor_ps(sign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+    return _mm_xor_ps(polySelect(r, j), sign);
+}
+
+inline __m128 cos(__m128 x) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u));
+    __m128i j;
+    __m128 r = reduce(_mm_andnot_ps(signMask, x), j);
+    j = _mm_sub_epi32(j, _mm_set1_epi32(2));
+    __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(j, _mm_set1_epi32(4)), 29));
+    return _mm_xor_ps(polySelect(r, j), sign);
+}
+#endif
+
+} // namespace trig
+
+// 맵별 중심선. 새 맵은 특수화를 하나 더 만들고 trackCenterXBatch(int, ...) 의 분기에 추가.
+template <int MAP> struct TrackCurve;
+
+// Map 1: 완만한 Sine 파형
+template <> struct TrackCurve<1> {
+    static float centerX(float z) { return trig::sin(z * 0.05f) * 10.0f; }
+#if TRACK_CURVE_SSE2
+    static __m128 centerX(__m128 z) {
+        return _mm_mul_ps(trig::sin(_mm_mul_ps(z, _mm_set1_ps(0.05f))), _mm_set1_ps(10.0f));
+    }
+#endif
+};
+
+// Map 2: 더 복잡하고 급격한 곡선
+template <> struct TrackCurve<2> {
+    static float centerX(float z) { return trig::sin(z * 0.1f) * 10.0f + trig::cos(z * 0.05f) * 5.0f; }
+#if TRACK_CURVE_SSE2
+    static __m128 centerX(__m128 z) {
+        __m128 a = _mm_mul_ps(trig::sin(_mm_mul_ps(z, _mm_set1_ps(0.1f))), _mm_set1_ps(10.0f));
+        __m128 b = _mm_mul_ps(trig::cos(_mm_mul_ps(z, _mm_set1_ps(0.05f))), _mm_set1_ps(5.0f));
+        return _mm_add_ps(a, b);
+    }
+#endif
+};
+
+// out[i] = 중심 X(z[i]). 16 개씩 (레지스터 4 개를 번갈아 계산해 다항식 지연을 숨김)
+template <int MAP>
+inline void trackCenterXBatch(const float* z, float* out, int count) {
+    typedef TrackCurve<MAP> Curve;
+    int i = 0;
+#if TRACK_CURVE_SSE2
+    for (; i + 16 <= count; i += 16) {
+        __m128 a = Curve::centerX(_mm_loadu_ps(z + i));
+        __m128 b = Curve::centerX(_mm_loadu_ps(z + i + 4));
+        __m128 c = Curve::centerX(_mm_loadu_ps(z + i + 8));
+        __m128 d = Curve::centerX(_mm_loadu_ps(z + i + 12));
+        _mm_storeu_ps(out + i, a);
+        _mm_storeu_ps(out + i + 4, b);
+        _mm_storeu_ps(out + i + 8, c);
+        _mm_storeu_ps(out + i + 12, d);
+    }
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, Curve::centerX(_mm_loadu_ps(z + i)));
+#endif
+    for (; i < count; ++i) out[i] = Curve::centerX(z[i]);
+}
+
+// 맵 번호가 실행 중에 정해질 때: 분기는 여기서 한 번
+inline void trackCenterXBatch(int mapType, const float* z, float* out, int count) {
+    if (mapType == 1) trackCenterXBatch<1>(z, out, count);
+    else trackCenterXBatch<2>(z, out, count);
+}
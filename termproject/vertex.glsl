@@ -4,26 +4,46 @@ layout (location = 0) in vec3 vPos;       // 
 layout (location = 1) in vec3 vColor;     // 
 layout (location = 2) in vec2 vTexCoord;  // ؽó ǥ
 layout (location = 3) in vec3 vNormal;    // [NEW]   ( )
+layout (location = 4) in mat4 iModel;     // νϽ   (ε, Ʈ, location 4~7)
+layout (location = 8) in vec4 iTint;      // νϽ  /  (Ʈ. 迭  ⺻ (1,1,1,1))
 
 out vec3 FragPos;   // ׸Ʈ  ǥ
 out vec3 Normal;    //  
 out vec3 Color;     // 
 out vec2 TexCoord;  // ؽó ǥ
+out float ViewDepth; // ī޶   (Ŭ )
+out vec4 Tint;       //    (a  )
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // model    (CPU  ׸⸶   )
+
+// Ӹ   ø    (fragment.glsl  ϰ )
+layout (std140) uniform SceneBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;        // xyz: ī޶ ġ (ݻ籤 )
+    vec4 clusterParams;  // x,y: Ŭ Ÿ ũ(px), z,w:  slice  scale, bias
+    ivec4 clusterDims;   // x,y,z: Ŭ 
+};
+
+uniform int useInstancing; // 1̸ model  νϽ  
 
 void main()
 {
+    mat4 world = (useInstancing == 1) ? iModel : model;
+
     //  ǥ  (   ǥ迡 )
-    FragPos = vec3(model * vec4(vPos, 1.0));
+    FragPos = vec3(world * vec4(vPos, 1.0));
     
-    //   ȯ (յ ϸ   Normal Matrix )
-    Normal = mat3(transpose(inverse(model))) * vNormal;
+    //   ȯ ( inverse  ʵ CPU   Normal Matrix )
+    // νϽ  ȸ + ̵̶   3x3    
+    Normal = (useInstancing == 1) ? mat3(iModel) * vNormal : normalMatrix * vNormal;
     
     Color = vColor;
+    Tint = (useInstancing == 1) ? iTint : vec4(1.0);
     TexCoord = vTexCoord;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    vec4 viewSpace = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewSpace.z;
+    gl_Position = projection * viewSpace;
 }
\ No newline at end of file